@@ -36,47 +36,157 @@
 
 /*
  * Sampling is a templated data processing library. This is a flexible way to
- * sample and process an arbitrary data set with minimal code. The SampleT<T> 
- * stores a vector of type T. It also keeps a map of processes which return type Y. 
- * The second part of the map is a std::function which returns Y. The first part of 
- * the map is a size_t, which represents your ID for the function. This is handy 
- * for creating enumerators to organize your processes.
+ * sample and process an arbitrary data set with minimal code. The SampleT<T>
+ * stores a vector of type T. It also keeps a map of processes which return type Y.
+ * The second part of the map is a callable which returns Y, optionally taking
+ * the window it should read as its argument. The first part of
+ * the map is a size_t, which represents your ID for the function. This is handy
+ * for creating enumerators to organize your processes. The map is a flat table
+ * indexed by ID, so keep IDs small.
+ *
+ * Samples are kept by a storage policy. VectorStorageT<T> (the default) keeps
+ * a contiguous std::vector. RingStorageT<T> keeps a circular buffer so pushing
+ * into a full window overwrites the oldest sample instead of shifting the rest.
+ * Either way, getWindow() returns the samples oldest-to-newest as at most two
+ * contiguous segments.
  */
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#if __cplusplus >= 201703L && defined( __has_include )
+#if __has_include( <memory_resource> )
+#include <memory_resource>
+#endif
+#endif
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <map>
+
+/*
+ * MappedRingStorageT and WindowExportT::writeTo() need POSIX. Define
+ * SAMPLING_NO_MMAP to leave MappedRingStorageT out.
+ */
+#if defined( __unix__ ) || defined( __APPLE__ )
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
+	#define SAMPLING_POSIX
+	#if !defined( SAMPLING_NO_MMAP )
+		#define SAMPLING_MMAP
+	#endif
+#endif
+
+/*
+ * The built-in reductions pick a SIMD path from the target flags the
+ * compiler was invoked with (-mavx2, -msse4.1, /arch:AVX2, NEON on ARM).
+ * Define SAMPLING_NO_SIMD to force the scalar fallback.
+ */
+#if !defined( SAMPLING_NO_SIMD )
+	#if defined( __AVX__ )
+		#include <immintrin.h>
+		#define SAMPLING_AVX
+	#endif
+	#if defined( __AVX2__ )
+		#define SAMPLING_AVX2
+	#endif
+	#if defined( __SSE4_1__ ) || defined( SAMPLING_AVX )
+		#include <smmintrin.h>
+		#define SAMPLING_SSE41
+	#endif
+	#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+		#include <emmintrin.h>
+		#define SAMPLING_SSE2
+	#endif
+	#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+		#include <arm_neon.h>
+		#define SAMPLING_NEON
+	#endif
+#endif
 
 namespace sampling {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * Without exception support (-fno-exceptions) the places that would throw
+ * abort instead. Use SamplerT::tryRunProcess() to handle bad IDs there.
+ */
+#if defined( __cpp_exceptions ) || defined( __EXCEPTIONS ) || defined( _CPPUNWIND )
+	#define SAMPLING_EXCEPTIONS
+	#define SAMPLING_THROW( e ) throw e
+#else
+	#define SAMPLING_THROW( e ) std::abort()
+#endif
+
+/*
+ * Exceptions only record the process ID and a static description when
+ * thrown; the message is formatted into a small buffer the first time
+ * what() is called.
+ */
 class Exception : public std::exception
 {
 public:
-	Exception()
+	Exception( const char* description = "", size_t index = 0 ) throw()
+		: mDescription( description ), mIndex( index )
 	{
+		mMessage[ 0 ] = 0;
 	}
 	
 	virtual ~Exception() throw()
 	{
 	}
+
+	inline size_t getIndex() const throw()
+	{
+		return mIndex;
+	}
 	
 	inline const char*	what() const throw()
 	{ 
+		if ( mMessage[ 0 ] == 0 ) {
+			snprintf( mMessage, sizeof( mMessage ), "%s: %llu", mDescription, (unsigned long long)mIndex );
+		}
 		return mMessage; 
 	}
 protected:
-	char mMessage[ 2048 ];
+	const char*		mDescription;
+	size_t			mIndex;
+	mutable char	mMessage[ 64 ];
 };
 
 class ExcProcNotFound : public Exception 
 {
 public:
 	ExcProcNotFound( size_t index ) throw()
+		: Exception( "Process not found", index )
 	{
-		printf( mMessage, "Process not found: %i", index );
 	}
 };
 
@@ -84,157 +194,7556 @@ class ExcProcUndefined : public Exception
 {
 public:
 	ExcProcUndefined( size_t index ) throw()
+		: Exception( "Process is undefined", index )
 	{
-		printf( mMessage, "Process is undefined: %i", index );
 	}
 };
 
+class ExcProcCycle : public Exception 
+{
+public:
+	ExcProcCycle( size_t index ) throw()
+		: Exception( "Process depends on itself", index )
+	{
+	}
+};
+
+// What tryRunProcess() reports instead of throwing
+enum ProcessError
+{
+	PROCESS_NONE, PROCESS_NOT_FOUND, PROCESS_UNDEFINED
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 
-template<typename T, typename Y>
-class SamplerT
+// The allocator A rebound to allocate U, sharing A's memory resource
+template<typename A, typename U>
+using RebindAllocT = typename std::allocator_traits<A>::template rebind_alloc<U>;
+
+/*
+ * A non-owning view of a contiguous run of samples.
+ */
+template<typename T>
+class SpanT
 {
+public:
+	SpanT()
+		: mData( nullptr ), mSize( 0 )
+	{
+	}
+
+	SpanT( T* data, size_t size )
+		: mData( data ), mSize( size )
+	{
+	}
+
+	template<typename U>
+	SpanT( const SpanT<U>& rhs )
+		: mData( rhs.data() ), mSize( rhs.size() )
+	{
+	}
+
+	inline T& operator[]( size_t index ) const
+	{
+		return mData[ index ];
+	}
+
+	inline T* begin() const
+	{
+		return mData;
+	}
+
+	inline T* end() const
+	{
+		return mData + mSize;
+	}
+
+	inline T* data() const
+	{
+		return mData;
+	}
+
+	inline bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+
+	inline SpanT subspan( size_t offset, size_t count ) const
+	{
+		return SpanT( mData + offset, count );
+	}
 protected:
-	size_t									mNumSamples;
-	std::map<size_t, std::function<Y()> >	mProcessMap;
-	std::vector<T>							mSamples;
+	T*		mData;
+	size_t	mSize;
+};
 
-	inline void fit()
+template<typename T>
+class StridedWindowT;
+
+/*
+ * A non-owning view of a sample window, oldest to newest, as at most two
+ * contiguous segments. The second segment is only used when the window wraps
+ * around the end of a ring buffer. Scanning first() then second() lets a
+ * process walk raw pointers without copying the samples.
+ */
+template<typename T>
+class WindowT
+{
+public:
+	class iterator
 	{
-		if ( mNumSamples < 1 ) {
-			mNumSamples = 1;
+	public:
+		typedef std::random_access_iterator_tag				iterator_category;
+		typedef typename std::remove_const<T>::type			value_type;
+		typedef ptrdiff_t									difference_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+
+		iterator()
+			: mFirst( nullptr ), mFirstSize( 0 ), mIndex( 0 ), mSecond( nullptr )
+		{
+		}
+
+		iterator( T* first, size_t firstSize, T* second, size_t index )
+			: mFirst( first ), mFirstSize( firstSize ), mIndex( index ), mSecond( second )
+		{
 		}
-		while ( mSamples.size() > mNumSamples ) {
-			mSamples.erase( mSamples.begin() );
+
+		inline reference operator*() const
+		{
+			return mIndex < mFirstSize ? mFirst[ mIndex ] : mSecond[ mIndex - mFirstSize ];
 		}
-		if ( mSamples.size() < mNumSamples ) {
-			size_t count = mNumSamples - mSamples.size();
-			mSamples.insert( mSamples.begin(), count, T() );
+
+		inline pointer operator->() const
+		{
+			return &**this;
+		}
+
+		inline reference operator[]( difference_type n ) const
+		{
+			return *( *this + n );
+		}
+
+		inline iterator& operator++()
+		{
+			++mIndex;
+			return *this;
+		}
+
+		inline iterator operator++( int )
+		{
+			iterator it = *this;
+			++mIndex;
+			return it;
+		}
+
+		inline iterator& operator--()
+		{
+			--mIndex;
+			return *this;
+		}
+
+		inline iterator operator--( int )
+		{
+			iterator it = *this;
+			--mIndex;
+			return it;
+		}
+
+		inline iterator& operator+=( difference_type n )
+		{
+			mIndex += n;
+			return *this;
+		}
+
+		inline iterator& operator-=( difference_type n )
+		{
+			mIndex -= n;
+			return *this;
+		}
+
+		inline iterator operator+( difference_type n ) const
+		{
+			iterator it = *this;
+			return it += n;
+		}
+
+		inline iterator operator-( difference_type n ) const
+		{
+			iterator it = *this;
+			return it -= n;
+		}
+
+		inline difference_type operator-( const iterator& rhs ) const
+		{
+			return (difference_type)mIndex - (difference_type)rhs.mIndex;
 		}
+
+		inline bool operator==( const iterator& rhs ) const
+		{
+			return mIndex == rhs.mIndex;
+		}
+
+		inline bool operator!=( const iterator& rhs ) const
+		{
+			return mIndex != rhs.mIndex;
+		}
+
+		inline bool operator<( const iterator& rhs ) const
+		{
+			return mIndex < rhs.mIndex;
+		}
+
+		inline bool operator>( const iterator& rhs ) const
+		{
+			return mIndex > rhs.mIndex;
+		}
+
+		inline bool operator<=( const iterator& rhs ) const
+		{
+			return mIndex <= rhs.mIndex;
+		}
+
+		inline bool operator>=( const iterator& rhs ) const
+		{
+			return mIndex >= rhs.mIndex;
+		}
+	protected:
+		T*		mFirst;
+		size_t	mFirstSize;
+		size_t	mIndex;
+		T*		mSecond;
+	};
+
+	WindowT()
+	{
 	}
-public:
-	SamplerT( size_t numSamples = 2 )
-		: mNumSamples( numSamples )
+
+	WindowT( const SpanT<T>& first, const SpanT<T>& second = SpanT<T>() )
+		: mFirst( first ), mSecond( second )
 	{
+		if ( mFirst.empty() ) {
+			mFirst	= mSecond;
+			mSecond	= SpanT<T>();
+		}
 	}
-	
-	SamplerT( const SamplerT& rhs )
+
+	template<typename U>
+	WindowT( const WindowT<U>& rhs )
+		: mFirst( rhs.first() ), mSecond( rhs.second() )
 	{
-		*this = rhs;
 	}
-	
-	SamplerT& operator=( const SamplerT& rhs )
+
+	inline T& operator[]( size_t index ) const
 	{
-		mNumSamples	= rhs.mNumSamples;
-		mProcessMap	= rhs.mProcessMap;
-		mSamples	= rhs.mSamples;
-		return *this;
+		return index < mFirst.size() ? mFirst[ index ] : mSecond[ index - mFirst.size() ];
 	}
 
-	inline SamplerT& process( size_t index, const std::function<Y()>& func )
+	inline iterator begin() const
 	{
-		setProcess( index, func );
-		return *this;
+		return iterator( mFirst.data(), mFirst.size(), mSecond.data(), 0 );
 	}
 
-	inline void	clearProcesses()
+	inline iterator end() const
 	{
-		mProcessMap.clear();
+		return iterator( mFirst.data(), mFirst.size(), mSecond.data(), size() );
 	}
 
-	inline void	eraseProcess( size_t index )
+	inline T& front() const
 	{
-		if ( mProcessMap.find( index ) != mProcessMap.end() ) {
-			mProcessMap.erase( index );
+		return mFirst[ 0 ];
+	}
+
+	inline T& back() const
+	{
+		return mSecond.empty() ? mFirst[ mFirst.size() - 1 ] : mSecond[ mSecond.size() - 1 ];
+	}
+
+	inline bool empty() const
+	{
+		return mFirst.empty();
+	}
+
+	inline size_t size() const
+	{
+		return mFirst.size() + mSecond.size();
+	}
+
+	inline const SpanT<T>& first() const
+	{
+		return mFirst;
+	}
+
+	inline const SpanT<T>& second() const
+	{
+		return mSecond;
+	}
+
+	inline bool isContiguous() const
+	{
+		return mSecond.empty();
+	}
+
+	/*
+	 * Views of part of the window over the same samples, for processes that
+	 * only read some of it. Indices are positions in this window, and are
+	 * clamped to it. range() and tail() are windows themselves, so the
+	 * reductions in reduce:: take them as they are.
+	 */
+	inline WindowT range( size_t first, size_t last ) const
+	{
+		last	= last < size() ? last : size();
+		first	= first < last ? first : last;
+		if ( first >= mFirst.size() ) {
+			return WindowT( mSecond.subspan( first - mFirst.size(), last - first ) );
+		}
+		if ( last <= mFirst.size() ) {
+			return WindowT( mFirst.subspan( first, last - first ) );
 		}
-		throw ExcProcNotFound( index );
+		return WindowT( mFirst.subspan( first, mFirst.size() - first ), mSecond.subspan( 0, last - mFirst.size() ) );
+	}
+
+	// The newest count samples
+	inline WindowT tail( size_t count ) const
+	{
+		return range( count < size() ? size() - count : 0, size() );
+	}
+
+	// Every step-th sample, ending with the newest
+	inline StridedWindowT<T> stride( size_t step ) const
+	{
+		return StridedWindowT<T>( *this, step );
 	}
 
-	inline std::function<Y()>& getProcess( size_t index )
+	// Calls func once per sample, oldest to newest, one segment at a time.
+	template<typename F>
+	inline void forEach( F func ) const
 	{
-		if ( mProcessMap.find( index ) != mProcessMap.end() ) {
-			return mProcessMap.at( index );
+		for ( T* v = mFirst.begin(); v != mFirst.end(); ++v ) {
+			func( *v );
+		}
+		for ( T* v = mSecond.begin(); v != mSecond.end(); ++v ) {
+			func( *v );
 		}
-		throw ExcProcNotFound( index );
 	}
+protected:
+	SpanT<T> mFirst;
+	SpanT<T> mSecond;
+};
 
-	inline const std::function<Y()>& getProcess( size_t index ) const
+/*
+ * A decimated view of a window: every step-th sample, oldest to newest,
+ * counted back from the newest so it stays in the view as the window
+ * slides. Nothing is copied. Like WindowT's, its iterators point at the
+ * samples rather than the view, so they outlive a temporary view.
+ */
+template<typename T>
+class StridedWindowT
+{
+public:
+	class iterator
 	{
-		if ( mProcessMap.find( index ) != mProcessMap.end() ) {
-			return mProcessMap.at( index );
+	public:
+		typedef std::random_access_iterator_tag				iterator_category;
+		typedef typename std::remove_const<T>::type			value_type;
+		typedef ptrdiff_t									difference_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+
+		iterator()
+			: mFirst( nullptr ), mFirstSize( 0 ), mIndex( 0 ), mOffset( 0 ), mSecond( nullptr ), mStep( 1 )
+		{
+		}
+
+		iterator( T* first, size_t firstSize, T* second, size_t offset, size_t step, size_t index )
+			: mFirst( first ), mFirstSize( firstSize ), mIndex( index ), mOffset( offset ), mSecond( second ), mStep( step )
+		{
+		}
+
+		inline reference operator*() const
+		{
+			size_t i = mOffset + mIndex * mStep;
+			return i < mFirstSize ? mFirst[ i ] : mSecond[ i - mFirstSize ];
+		}
+
+		inline pointer operator->() const
+		{
+			return &**this;
+		}
+
+		inline reference operator[]( difference_type n ) const
+		{
+			return *( *this + n );
+		}
+
+		inline iterator& operator++()
+		{
+			++mIndex;
+			return *this;
+		}
+
+		inline iterator operator++( int )
+		{
+			iterator it = *this;
+			++mIndex;
+			return it;
+		}
+
+		inline iterator& operator--()
+		{
+			--mIndex;
+			return *this;
+		}
+
+		inline iterator operator--( int )
+		{
+			iterator it = *this;
+			--mIndex;
+			return it;
+		}
+
+		inline iterator& operator+=( difference_type n )
+		{
+			mIndex += n;
+			return *this;
+		}
+
+		inline iterator& operator-=( difference_type n )
+		{
+			mIndex -= n;
+			return *this;
+		}
+
+		inline iterator operator+( difference_type n ) const
+		{
+			iterator it = *this;
+			return it += n;
+		}
+
+		inline iterator operator-( difference_type n ) const
+		{
+			iterator it = *this;
+			return it -= n;
+		}
+
+		inline difference_type operator-( const iterator& rhs ) const
+		{
+			return (difference_type)mIndex - (difference_type)rhs.mIndex;
+		}
+
+		inline bool operator==( const iterator& rhs ) const
+		{
+			return mIndex == rhs.mIndex;
 		}
-		throw ExcProcNotFound( index );
+
+		inline bool operator!=( const iterator& rhs ) const
+		{
+			return mIndex != rhs.mIndex;
+		}
+
+		inline bool operator<( const iterator& rhs ) const
+		{
+			return mIndex < rhs.mIndex;
+		}
+
+		inline bool operator>( const iterator& rhs ) const
+		{
+			return mIndex > rhs.mIndex;
+		}
+
+		inline bool operator<=( const iterator& rhs ) const
+		{
+			return mIndex <= rhs.mIndex;
+		}
+
+		inline bool operator>=( const iterator& rhs ) const
+		{
+			return mIndex >= rhs.mIndex;
+		}
+	protected:
+		T*		mFirst;
+		size_t	mFirstSize;
+		size_t	mIndex;
+		size_t	mOffset;
+		T*		mSecond;
+		size_t	mStep;
+	};
+
+	StridedWindowT()
+		: mOffset( 0 ), mSize( 0 ), mStep( 1 )
+	{
 	}
 
-	inline void setProcess( size_t index, const std::function<Y()>& func )
+	StridedWindowT( const WindowT<T>& window, size_t step )
+		: mStep( step > 0 ? step : 1 ), mWindow( window )
 	{
-		mProcessMap[ index ] = func;
+		mOffset	= window.empty() ? 0 : ( window.size() - 1 ) % mStep;
+		mSize	= window.empty() ? 0 : ( window.size() - 1 ) / mStep + 1;
 	}
 
-	inline std::map<size_t, std::function<Y()> >& getProcessMap()
+	template<typename U>
+	StridedWindowT( const StridedWindowT<U>& rhs )
+		: mOffset( rhs.getOffset() ), mSize( rhs.size() ), mStep( rhs.getStep() ), mWindow( rhs.getWindow() )
 	{
-		return mProcessMap;
 	}
 
-	inline const std::map<size_t, std::function<Y()> >&	getProcessMap() const
+	inline T& operator[]( size_t index ) const
 	{
-		return mProcessMap;
+		return mWindow[ mOffset + index * mStep ];
 	}
 
-	inline Y runProcess( size_t index )
+	inline iterator begin() const
 	{
-		if ( mProcessMap.find( index ) != mProcessMap.end() ) {
-			if ( mProcessMap.at( index ) != nullptr ) {
-				return mProcessMap.at( index )();
-			}
-			throw ExcProcUndefined( index );
-		}
-		throw ExcProcNotFound( index );
+		return iterator( mWindow.first().data(), mWindow.first().size(), mWindow.second().data(), mOffset, mStep, 0 );
 	}
 
-	inline size_t getNumSamples() const
+	inline iterator end() const
 	{
-		return mNumSamples;
+		return iterator( mWindow.first().data(), mWindow.first().size(), mWindow.second().data(), mOffset, mStep, mSize );
 	}
-	
-	inline void setNumSamples( size_t numSamples )
+
+	inline T& front() const
 	{
-		mNumSamples = numSamples;
-		fit();
+		return ( *this )[ 0 ];
 	}
 
-	inline void clearSamples()
+	inline T& back() const
 	{
-		mSamples.clear();
+		return ( *this )[ mSize - 1 ];
 	}
 
-	inline void eraseSample( size_t index )
+	inline bool empty() const
 	{
-		if ( mSamples.size() > index ) {
-			mSamples.erase( mSamples.begin() + index );
+		return mSize == 0;
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+
+	// Position of the first sample in the underlying window
+	inline size_t getOffset() const
+	{
+		return mOffset;
+	}
+
+	inline size_t getStep() const
+	{
+		return mStep;
+	}
+
+	inline const WindowT<T>& getWindow() const
+	{
+		return mWindow;
+	}
+
+	// Calls func once per sample, oldest to newest, one segment at a time
+	template<typename F>
+	inline void forEach( F func ) const
+	{
+		const SpanT<T>& first	= mWindow.first();
+		const SpanT<T>& second	= mWindow.second();
+		size_t i = mOffset;
+		for ( ; i < first.size(); i += mStep ) {
+			func( first[ i ] );
+		}
+		for ( i -= first.size(); i < second.size(); i += mStep ) {
+			func( second[ i ] );
 		}
 	}
+protected:
+	size_t		mOffset;
+	size_t		mSize;
+	size_t		mStep;
+	WindowT<T>	mWindow;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
 
-	std::vector<T>& getSamples()
+/*
+ * Storage policies keep the samples for a SamplerT, oldest first. Besides
+ * size(), indexing and iteration, a policy provides append(), clear(),
+ * erase(), eraseFront(), insert(), maxSize(), padFront(), pushBack(),
+ * reserve(), shrinkToFit(), getWindow() and container(), which is what
+ * SamplerT::getSamples() hands out. Policies take an allocator A, and the
+ * sampler allocates its process tables from a copy of it, so a pool or
+ * arena (e.g. std::pmr::polymorphic_allocator) can back a whole sampler.
+ */
+
+/*
+ * Keeps the samples in a std::vector, behind a run of spare slots at the
+ * front. Evicting the oldest samples or padding in front of them moves the
+ * offset rather than the samples, and the spare slots keep their old value
+ * until they are reused. getSamples() hands out the vector itself, so
+ * container() first closes the gap, shifting the window once; this suits
+ * small windows or code that needs a plain std::vector from getSamples().
+ */
+template<typename T, typename A = std::allocator<T> >
+class VectorStorageT
+{
+public:
+	typedef A										allocator_type;
+	typedef std::vector<T, A>						container_type;
+	typedef typename container_type::iterator		iterator;
+	typedef typename container_type::const_iterator	const_iterator;
+
+	explicit VectorStorageT( const A& allocator = A() )
+		: mData( allocator ), mOffset( 0 )
 	{
-		return mSamples;
 	}
 
-	const std::vector<T>& getSamples() const
+	// Copies only the window, into the same allocator rather than the one std::vector would select
+	VectorStorageT( const VectorStorageT& rhs )
+		: mData( rhs.begin(), rhs.end(), rhs.getAllocator() ), mOffset( 0 )
 	{
-		return mSamples;
 	}
 
-	inline void insertSample( size_t index, const T& v )
+	VectorStorageT( VectorStorageT&& rhs )
+		: mData( std::move( rhs.mData ) ), mOffset( rhs.mOffset )
 	{
-		mSamples.insert( mSamples.begin() + index, v );
-		fit();
+		rhs.clear();
 	}
 
-	inline void	pushBack( const T& v )
+	VectorStorageT& operator=( const VectorStorageT& rhs ) = default;
+
+	VectorStorageT& operator=( VectorStorageT&& rhs )
 	{
-		mSamples.push_back( v );
-		fit();
+		if ( this != &rhs ) {
+			mData	= std::move( rhs.mData );
+			mOffset	= rhs.mOffset;
+			rhs.clear();
+		}
+		return *this;
+	}
+
+	inline T& operator[]( size_t index )
+	{
+		return mData[ mOffset + index ];
+	}
+
+	inline const T& operator[]( size_t index ) const
+	{
+		return mData[ mOffset + index ];
+	}
+
+	inline iterator begin()
+	{
+		return mData.begin() + mOffset;
+	}
+
+	inline const_iterator begin() const
+	{
+		return mData.cbegin() + mOffset;
+	}
+
+	inline iterator end()
+	{
+		return mData.end();
+	}
+
+	inline const_iterator end() const
+	{
+		return mData.end();
+	}
+
+	inline T& front()
+	{
+		return mData[ mOffset ];
+	}
+
+	inline const T& front() const
+	{
+		return mData[ mOffset ];
+	}
+
+	inline T& back()
+	{
+		return mData.back();
+	}
+
+	inline const T& back() const
+	{
+		return mData.back();
+	}
+
+	inline bool empty() const
+	{
+		return mData.size() == mOffset;
+	}
+
+	inline size_t size() const
+	{
+		return mData.size() - mOffset;
+	}
+
+	inline allocator_type getAllocator() const
+	{
+		return mData.get_allocator();
+	}
+
+	inline size_t maxSize() const
+	{
+		return mData.max_size();
+	}
+
+	inline container_type& container()
+	{
+		compact();
+		return mData;
+	}
+
+	inline const container_type& container() const
+	{
+		compact();
+		return mData;
+	}
+
+	inline WindowT<T> getWindow()
+	{
+		return WindowT<T>( SpanT<T>( mData.data() + mOffset, size() ) );
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		return WindowT<const T>( SpanT<const T>( mData.data() + mOffset, size() ) );
+	}
+
+	template<typename Iter>
+	inline void append( Iter first, Iter last )
+	{
+		mData.insert( mData.end(), first, last );
+	}
+
+	inline void clear()
+	{
+		mData.clear();
+		mOffset = 0;
+	}
+
+	inline void erase( size_t index )
+	{
+		mData.erase( begin() + index );
+	}
+
+	// Closes the gap once it outgrows the window, so pushes stay amortised O(1)
+	inline void eraseFront( size_t count )
+	{
+		mOffset += count;
+		if ( mOffset > size() ) {
+			compact();
+		}
+	}
+
+	inline void insert( size_t index, const T& v )
+	{
+		mData.insert( begin() + index, v );
+	}
+
+	// Runs out of spare slots only every size() / 2 samples of padding
+	inline void padFront( size_t count )
+	{
+		if ( count > mOffset ) {
+			size_t spare = count - mOffset + size() / 2;
+			mData.insert( mData.begin(), spare, T() );
+			mOffset += spare;
+		}
+		mOffset -= count;
+		std::fill( begin(), begin() + count, T() );
+	}
+
+	inline void pushBack( const T& v )
+	{
+		mData.push_back( v );
+	}
+
+	inline void pushBack( T&& v )
+	{
+		mData.push_back( std::move( v ) );
+	}
+
+	// Grows by at least half, so growing a window a slot at a time moves each sample O(1) times
+	inline void reserve( size_t capacity )
+	{
+		if ( mOffset + capacity > mData.capacity() ) {
+			compact();
+			size_t grown = mData.capacity() + mData.capacity() / 2;
+			mData.reserve( capacity > grown ? capacity : grown );
+		}
+	}
+
+	inline void shrinkToFit()
+	{
+		compact();
+		mData.shrink_to_fit();
+	}
+protected:
+	mutable container_type	mData;
+	mutable size_t			mOffset;	// spare slots in front of the oldest sample
+
+	inline void compact() const
+	{
+		if ( mOffset > 0 ) {
+			mData.erase( mData.begin(), mData.begin() + mOffset );
+			mOffset = 0;
+		}
+	}
+};
+
+/*
+ * Keeps the samples in a circular buffer. Pushing into a full window
+ * overwrites the oldest slot and moves the head index, so nothing is shifted.
+ * Every slot stays constructed; slots that fall out of the window keep their
+ * old value until they are reused. getSamples() returns the storage itself,
+ * which indexes and iterates oldest to newest like a vector would.
+ *
+ * The slots live in a reference-counted buffer that share() hands out, so
+ * SamplerT::snapshot() can pin the window without copying it. While any
+ * snapshot still holds the buffer, the next write, or non-const access to
+ * a sample, first moves the live samples to a fresh buffer (once), leaving
+ * the old one to the snapshots; with none alive writes go straight through.
+ */
+template<typename T, typename A = std::allocator<T> >
+class RingStorageT
+{
+public:
+	typedef A										allocator_type;
+	typedef RingStorageT<T, A>						container_type;
+	typedef typename WindowT<T>::iterator			iterator;
+	typedef typename WindowT<const T>::iterator		const_iterator;
+
+	explicit RingStorageT( const A& allocator = A() )
+		: mAllocator( allocator ), mCapacity( 0 ), mData( nullptr ), mHead( 0 ), mShared( false ), mSize( 0 )
+	{
+	}
+
+	// Copies the live samples into a buffer of their own
+	RingStorageT( const RingStorageT& rhs )
+		: mAllocator( rhs.mAllocator ), mCapacity( 0 ), mData( nullptr ), mHead( 0 ), mShared( false ), mSize( 0 )
+	{
+		copyFrom( rhs );
+	}
+
+	RingStorageT( RingStorageT&& rhs ) noexcept
+		: mAllocator( rhs.mAllocator ), mBuffer( std::move( rhs.mBuffer ) ), mCapacity( rhs.mCapacity ),
+		mData( rhs.mData ), mHead( rhs.mHead ), mShared( rhs.mShared ), mSize( rhs.mSize )
+	{
+		rhs.mCapacity	= 0;
+		rhs.mData		= nullptr;
+		rhs.mHead		= 0;
+		rhs.mShared		= false;
+		rhs.mSize		= 0;
+	}
+
+	RingStorageT& operator=( const RingStorageT& rhs )
+	{
+		if ( this != &rhs ) {
+			copyFrom( rhs );
+		}
+		return *this;
+	}
+
+	RingStorageT& operator=( RingStorageT&& rhs ) noexcept
+	{
+		if ( this != &rhs ) {
+			mBuffer		= std::move( rhs.mBuffer );
+			mCapacity	= rhs.mCapacity;
+			mData		= rhs.mData;
+			mHead		= rhs.mHead;
+			mShared		= rhs.mShared;
+			mSize		= rhs.mSize;
+			rhs.mCapacity	= 0;
+			rhs.mData		= nullptr;
+			rhs.mHead		= 0;
+			rhs.mShared		= false;
+			rhs.mSize		= 0;
+		}
+		return *this;
+	}
+
+	inline T& operator[]( size_t index )
+	{
+		detach();
+		return mData[ wrap( mHead + index ) ];
+	}
+
+	inline const T& operator[]( size_t index ) const
+	{
+		return mData[ wrap( mHead + index ) ];
+	}
+
+	inline iterator begin()
+	{
+		return getWindow().begin();
+	}
+
+	inline const_iterator begin() const
+	{
+		return getWindow().begin();
+	}
+
+	inline iterator end()
+	{
+		return getWindow().end();
+	}
+
+	inline const_iterator end() const
+	{
+		return getWindow().end();
+	}
+
+	inline T& front()
+	{
+		detach();
+		return mData[ mHead ];
+	}
+
+	inline const T& front() const
+	{
+		return mData[ mHead ];
+	}
+
+	inline T& back()
+	{
+		return ( *this )[ mSize - 1 ];
+	}
+
+	inline const T& back() const
+	{
+		return ( *this )[ mSize - 1 ];
+	}
+
+	inline size_t capacity() const
+	{
+		return mCapacity;
+	}
+
+	inline allocator_type getAllocator() const
+	{
+		return mAllocator;
+	}
+
+	inline size_t maxSize() const
+	{
+		return std::allocator_traits<A>::max_size( mAllocator );
+	}
+
+	inline bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+
+	inline container_type& container()
+	{
+		return *this;
+	}
+
+	inline const container_type& container() const
+	{
+		return *this;
+	}
+
+	inline WindowT<T> getWindow()
+	{
+		if ( mSize == 0 ) {
+			return WindowT<T>();
+		}
+		detach();
+		size_t count = mSize < mCapacity - mHead ? mSize : mCapacity - mHead;
+		return WindowT<T>( SpanT<T>( mData + mHead, count ), SpanT<T>( mData, mSize - count ) );
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		if ( mSize == 0 ) {
+			return WindowT<const T>();
+		}
+		size_t count = mSize < mCapacity - mHead ? mSize : mCapacity - mHead;
+		return WindowT<const T>( SpanT<const T>( mData + mHead, count ), SpanT<const T>( mData, mSize - count ) );
+	}
+
+	// Whether a snapshot still holds the buffer the window lives in
+	inline bool isShared() const
+	{
+		return mBuffer.use_count() > 1;
+	}
+
+	// Keeps the buffer behind getWindow() alive; see the class comment
+	inline std::shared_ptr<const void> share() const
+	{
+		mShared = true;
+		return mBuffer;
+	}
+
+	// Copies the range into the free slots as at most two contiguous runs
+	template<typename Iter>
+	inline void append( Iter first, Iter last )
+	{
+		size_t count = std::distance( first, last );
+		if ( mSize + count > mCapacity ) {
+			reallocate( mSize + count > mCapacity * 2 ? mSize + count : mCapacity * 2 );
+		} else {
+			detach();
+		}
+		size_t tail		= wrap( mHead + mSize );
+		size_t n		= count < mCapacity - tail ? count : mCapacity - tail;
+		Iter mid		= first;
+		std::advance( mid, n );
+		std::copy( first, mid, mData + tail );
+		std::copy( mid, last, mData );
+		mSize += count;
+	}
+
+	inline void clear()
+	{
+		mHead = 0;
+		mSize = 0;
+	}
+
+	inline void erase( size_t index )
+	{
+		// Close the gap from whichever side is shorter
+		detach();
+		if ( index < mSize / 2 ) {
+			for ( size_t i = index; i > 0; --i ) {
+				at( i ) = std::move( at( i - 1 ) );
+			}
+			mHead = wrap( mHead + 1 );
+		} else {
+			for ( size_t i = index; i + 1 < mSize; ++i ) {
+				at( i ) = std::move( at( i + 1 ) );
+			}
+		}
+		--mSize;
+	}
+
+	// Only moves the head, so snapshots never need a copy for it
+	inline void eraseFront( size_t count )
+	{
+		mHead = wrap( mHead + count );
+		mSize -= count;
+	}
+
+	inline void insert( size_t index, const T& v )
+	{
+		T value( v );
+		if ( mSize == mCapacity ) {
+			reallocate( mCapacity == 0 ? 1 : mCapacity * 2 );
+		} else {
+			detach();
+		}
+		if ( index < mSize / 2 ) {
+			mHead = wrap( mHead + mCapacity - 1 );
+			++mSize;
+			for ( size_t i = 0; i < index; ++i ) {
+				at( i ) = std::move( at( i + 1 ) );
+			}
+		} else {
+			++mSize;
+			for ( size_t i = mSize - 1; i > index; --i ) {
+				at( i ) = std::move( at( i - 1 ) );
+			}
+		}
+		at( index ) = std::move( value );
+	}
+
+	inline void padFront( size_t count )
+	{
+		reserve( mSize + count );
+		detach();
+		mHead = wrap( mHead + mCapacity - count );
+		mSize += count;
+		for ( size_t i = 0; i < count; ++i ) {
+			at( i ) = T();
+		}
+	}
+
+	inline void pushBack( const T& v )
+	{
+		if ( mSize == mCapacity ) {
+			T value( v );
+			reallocate( mCapacity == 0 ? 1 : mCapacity * 2 );
+			mData[ wrap( mHead + mSize ) ] = std::move( value );
+		} else {
+			detach();
+			mData[ wrap( mHead + mSize ) ] = v;
+		}
+		++mSize;
+	}
+
+	inline void pushBack( T&& v )
+	{
+		if ( mSize == mCapacity ) {
+			T value( std::move( v ) );
+			reallocate( mCapacity == 0 ? 1 : mCapacity * 2 );
+			mData[ wrap( mHead + mSize ) ] = std::move( value );
+		} else {
+			detach();
+			mData[ wrap( mHead + mSize ) ] = std::move( v );
+		}
+		++mSize;
+	}
+
+	// Grows by at least half, so growing a window a slot at a time moves each sample O(1) times
+	inline void reserve( size_t capacity )
+	{
+		if ( capacity > mCapacity ) {
+			size_t grown = mCapacity + mCapacity / 2;
+			reallocate( capacity > grown ? capacity : grown );
+		}
+	}
+
+	inline void shrinkToFit()
+	{
+		if ( mSize < mCapacity ) {
+			reallocate( mSize );
+		}
+	}
+protected:
+	typedef std::vector<T, A>	Buffer;
+
+	A						mAllocator;
+	std::shared_ptr<Buffer>	mBuffer;
+	size_t					mCapacity;	// mBuffer->size(), and mData its data(), kept
+	T*						mData;		// here to spare the extra indirection
+	size_t					mHead;
+	mutable bool			mShared;	// share() was called since the last detach()
+	size_t					mSize;
+
+	// Sample index without detaching, for loops that detached up front
+	inline T& at( size_t index )
+	{
+		return mData[ wrap( mHead + index ) ];
+	}
+
+	// Only valid for index < 2 * capacity, which is all the ring ever needs
+	inline size_t wrap( size_t index ) const
+	{
+		return index >= mCapacity ? index - mCapacity : index;
+	}
+
+	inline void copyFrom( const RingStorageT& rhs )
+	{
+		mHead = 0;
+		mSize = 0;
+		if ( rhs.mCapacity == 0 ) {
+			mBuffer.reset();
+			mCapacity	= 0;
+			mData		= nullptr;
+			mShared		= false;
+			return;
+		}
+		reallocate( rhs.mCapacity );
+		for ( size_t i = 0; i < rhs.mSize; ++i ) {
+			mData[ i ] = rhs[ i ];
+		}
+		mSize = rhs.mSize;
+	}
+
+	// Leaves the buffer to the snapshots still holding it before a write
+	inline void detach()
+	{
+		if ( !mShared ) {
+			return;
+		}
+		if ( mBuffer.use_count() > 1 ) {
+			reallocate( mCapacity );
+		} else {
+			// Pairs with the release in the last snapshot's shared_ptr, so
+			// its reads happen before the slots are reused
+			std::atomic_thread_fence( std::memory_order_acquire );
+			mShared = false;
+		}
+	}
+
+	inline void reallocate( size_t capacity )
+	{
+		std::shared_ptr<Buffer> buffer = std::allocate_shared<Buffer>( RebindAllocT<A, Buffer>( mAllocator ),
+			Buffer( capacity, mAllocator ) );
+		T* data = buffer->data();
+		bool shared = mBuffer.use_count() > 1;
+		for ( size_t i = 0; i < mSize; ++i ) {
+			data[ i ] = shared ? at( i ) : std::move( at( i ) );
+		}
+		mBuffer.swap( buffer );
+		mCapacity	= capacity;
+		mData		= data;
+		mHead		= 0;
+		mShared		= false;
+	}
+};
+
+/*
+ * A ring buffer of compile-time capacity N (a power of two) stored inline,
+ * so the sampler needs no heap allocation for its samples and wraps
+ * indices with a mask. The window can be smaller than N but never larger;
+ * SamplerT clamps getNumSamples() to N. forEach() runs a loop with a
+ * constant trip count of N once the window is full, so process bodies
+ * built on it can be unrolled and constant-folded.
+ */
+template<typename T, size_t N>
+class FixedRingStorageT
+{
+	static_assert( N > 0 && ( N & ( N - 1 ) ) == 0, "FixedRingStorageT capacity must be a power of two" );
+public:
+	typedef std::allocator<T>						allocator_type;
+	typedef FixedRingStorageT<T, N>					container_type;
+	typedef typename WindowT<T>::iterator			iterator;
+	typedef typename WindowT<const T>::iterator		const_iterator;
+
+	static const size_t kCapacity	= N;
+	static const size_t kMask		= N - 1;
+
+	explicit FixedRingStorageT( const allocator_type& = allocator_type() )
+		: mData(), mHead( 0 ), mSize( 0 )
+	{
+	}
+
+	inline T& operator[]( size_t index )
+	{
+		return mData[ ( mHead + index ) & kMask ];
+	}
+
+	inline const T& operator[]( size_t index ) const
+	{
+		return mData[ ( mHead + index ) & kMask ];
+	}
+
+	inline iterator begin()
+	{
+		return getWindow().begin();
+	}
+
+	inline const_iterator begin() const
+	{
+		return getWindow().begin();
+	}
+
+	inline iterator end()
+	{
+		return getWindow().end();
+	}
+
+	inline const_iterator end() const
+	{
+		return getWindow().end();
+	}
+
+	inline T& front()
+	{
+		return mData[ mHead ];
+	}
+
+	inline const T& front() const
+	{
+		return mData[ mHead ];
+	}
+
+	inline T& back()
+	{
+		return ( *this )[ mSize - 1 ];
+	}
+
+	inline const T& back() const
+	{
+		return ( *this )[ mSize - 1 ];
+	}
+
+	inline size_t capacity() const
+	{
+		return N;
+	}
+
+	inline allocator_type getAllocator() const
+	{
+		return allocator_type();
+	}
+
+	inline bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	inline bool full() const
+	{
+		return mSize == N;
+	}
+
+	inline size_t maxSize() const
+	{
+		return N;
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+
+	inline container_type& container()
+	{
+		return *this;
+	}
+
+	inline const container_type& container() const
+	{
+		return *this;
+	}
+
+	inline WindowT<T> getWindow()
+	{
+		size_t count = mSize < N - mHead ? mSize : N - mHead;
+		return WindowT<T>( SpanT<T>( mData.data() + mHead, count ), SpanT<T>( mData.data(), mSize - count ) );
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		size_t count = mSize < N - mHead ? mSize : N - mHead;
+		return WindowT<const T>( SpanT<const T>( mData.data() + mHead, count ), SpanT<const T>( mData.data(), mSize - count ) );
+	}
+
+	// Calls func once per sample, oldest to newest
+	template<typename F>
+	inline void forEach( F func ) const
+	{
+		if ( mSize == N ) {
+			for ( size_t i = 0; i < N; ++i ) {
+				func( mData[ ( mHead + i ) & kMask ] );
+			}
+		} else {
+			for ( size_t i = 0; i < mSize; ++i ) {
+				func( mData[ ( mHead + i ) & kMask ] );
+			}
+		}
+	}
+
+	template<typename Iter>
+	inline void append( Iter first, Iter last )
+	{
+		for ( ; first != last; ++first ) {
+			mData[ ( mHead + mSize ) & kMask ] = *first;
+			++mSize;
+		}
+	}
+
+	inline void clear()
+	{
+		mHead = 0;
+		mSize = 0;
+	}
+
+	inline void erase( size_t index )
+	{
+		if ( index < mSize / 2 ) {
+			for ( size_t i = index; i > 0; --i ) {
+				( *this )[ i ] = std::move( ( *this )[ i - 1 ] );
+			}
+			mHead = ( mHead + 1 ) & kMask;
+		} else {
+			for ( size_t i = index; i + 1 < mSize; ++i ) {
+				( *this )[ i ] = std::move( ( *this )[ i + 1 ] );
+			}
+		}
+		--mSize;
+	}
+
+	inline void eraseFront( size_t count )
+	{
+		mHead = ( mHead + count ) & kMask;
+		mSize -= count;
+	}
+
+	inline void insert( size_t index, const T& v )
+	{
+		T value( v );
+		if ( index < mSize / 2 ) {
+			mHead = ( mHead + N - 1 ) & kMask;
+			++mSize;
+			for ( size_t i = 0; i < index; ++i ) {
+				( *this )[ i ] = std::move( ( *this )[ i + 1 ] );
+			}
+		} else {
+			++mSize;
+			for ( size_t i = mSize - 1; i > index; --i ) {
+				( *this )[ i ] = std::move( ( *this )[ i - 1 ] );
+			}
+		}
+		( *this )[ index ] = std::move( value );
+	}
+
+	inline void padFront( size_t count )
+	{
+		mHead = ( mHead + N - count ) & kMask;
+		mSize += count;
+		for ( size_t i = 0; i < count; ++i ) {
+			( *this )[ i ] = T();
+		}
+	}
+
+	inline void pushBack( const T& v )
+	{
+		mData[ ( mHead + mSize ) & kMask ] = v;
+		++mSize;
+	}
+
+	inline void pushBack( T&& v )
+	{
+		mData[ ( mHead + mSize ) & kMask ] = std::move( v );
+		++mSize;
+	}
+
+	inline void reserve( size_t )
+	{
+	}
+
+	inline void shrinkToFit()
+	{
+	}
+protected:
+	std::array<T, N>	mData;
+	size_t				mHead;
+	size_t				mSize;
+};
+
+#if defined( SAMPLING_MMAP )
+
+/*
+ * The layout at the start of a MappedRingStorageT file. Samples follow at
+ * kDataOffset. generation is a seqlock: odd while the writer is changing
+ * the ring, advanced by two per change.
+ */
+struct MappedRingHeader
+{
+	static const uint64_t	kMagic		= 0x474e495244504d53ull;	// "SMPDRING"
+	static const uint32_t	kVersion	= 1;
+	static const size_t		kDataOffset	= 64;
+
+	uint64_t				magic;
+	uint32_t				version;
+	uint32_t				sampleSize;
+	uint64_t				capacity;
+	uint64_t				head;
+	uint64_t				size;
+	std::atomic<uint64_t>	generation;
+};
+
+/*
+ * A ring buffer storage policy whose samples live in a memory-mapped file,
+ * for trivially copyable T. The header (capacity, head, size, generation)
+ * is part of the mapping too, so the file is always current with no copy
+ * or write call on the ingest path, and reopening it resumes the window:
+ *
+ *	typedef SamplerT<float, float, MappedRingStorageT<float> > Telemetry;
+ *	Telemetry telemetry( 1 << 20, MappedRingStorageT<float>( "telemetry.ring", 1 << 20 ) );
+ *
+ * Other processes can read the file while it is written with
+ * MappedRingReaderT. Default construction maps anonymous memory, which
+ * behaves like RingStorageT. Growing the ring remaps it; shrinkToFit()
+ * truncates the file, which attached readers must not be reading at the
+ * time. Errors opening or mapping the file throw std::system_error.
+ */
+template<typename T>
+class MappedRingStorageT
+{
+	static_assert( std::is_trivially_copyable<T>::value, "MappedRingStorageT requires a trivially copyable sample type" );
+public:
+	typedef std::allocator<T>						allocator_type;
+	typedef MappedRingStorageT<T>					container_type;
+	typedef typename WindowT<T>::iterator			iterator;
+	typedef typename WindowT<const T>::iterator		const_iterator;
+
+	explicit MappedRingStorageT( const allocator_type& = allocator_type() )
+		: mData( nullptr ), mFile( -1 ), mHeader( nullptr ), mMapSize( 0 )
+	{
+		map( 0 );
+		init( 0 );
+	}
+
+	/*
+	 * Opens or creates the file at path. An existing ring of the same sample
+	 * size is resumed, grown to capacity if it is smaller; anything else is
+	 * replaced by an empty ring.
+	 */
+	MappedRingStorageT( const char* path, size_t capacity )
+		: mData( nullptr ), mFile( -1 ), mHeader( nullptr ), mMapSize( 0 )
+	{
+		mFile = ::open( path, O_RDWR | O_CREAT, 0644 );
+		if ( mFile < 0 ) {
+			fail( "MappedRingStorageT: open" );
+		}
+		struct stat info;
+		if ( ::fstat( mFile, &info ) != 0 ) {
+			fail( "MappedRingStorageT: fstat" );
+		}
+		size_t fileSize = (size_t)info.st_size;
+		if ( fileSize >= MappedRingHeader::kDataOffset ) {
+			map( ( fileSize - MappedRingHeader::kDataOffset ) / sizeof( T ) );
+			if ( isValid( fileSize ) ) {
+				// A writer that died mid-change left the seqlock odd; close it
+				uint64_t generation = mHeader->generation.load( std::memory_order_relaxed );
+				mHeader->generation.store( generation + ( generation & 1 ), std::memory_order_release );
+				reserve( capacity );
+				return;
+			}
+			unmap();
+		}
+		resize( capacity );
+		map( capacity );
+		init( capacity );
+	}
+
+	MappedRingStorageT( const MappedRingStorageT& ) = delete;
+	MappedRingStorageT& operator=( const MappedRingStorageT& ) = delete;
+
+	// rhs is left as an empty anonymous ring, detached from its file
+	MappedRingStorageT( MappedRingStorageT&& rhs )
+		: mData( nullptr ), mFile( -1 ), mHeader( nullptr ), mMapSize( 0 )
+	{
+		*this = std::move( rhs );
+	}
+
+	MappedRingStorageT& operator=( MappedRingStorageT&& rhs )
+	{
+		if ( this != &rhs ) {
+			release();
+			std::swap( mData, rhs.mData );
+			std::swap( mFile, rhs.mFile );
+			std::swap( mHeader, rhs.mHeader );
+			std::swap( mMapSize, rhs.mMapSize );
+			rhs.map( 0 );
+			rhs.init( 0 );
+		}
+		return *this;
+	}
+
+	~MappedRingStorageT()
+	{
+		release();
+	}
+
+	inline T& operator[]( size_t index )
+	{
+		return mData[ wrap( mHeader->head + index ) ];
+	}
+
+	inline const T& operator[]( size_t index ) const
+	{
+		return mData[ wrap( mHeader->head + index ) ];
+	}
+
+	inline iterator begin()
+	{
+		return getWindow().begin();
+	}
+
+	inline const_iterator begin() const
+	{
+		return getWindow().begin();
+	}
+
+	inline iterator end()
+	{
+		return getWindow().end();
+	}
+
+	inline const_iterator end() const
+	{
+		return getWindow().end();
+	}
+
+	inline T& front()
+	{
+		return mData[ mHeader->head ];
+	}
+
+	inline const T& front() const
+	{
+		return mData[ mHeader->head ];
+	}
+
+	inline T& back()
+	{
+		return ( *this )[ mHeader->size - 1 ];
+	}
+
+	inline const T& back() const
+	{
+		return ( *this )[ mHeader->size - 1 ];
+	}
+
+	inline size_t capacity() const
+	{
+		return (size_t)mHeader->capacity;
+	}
+
+	inline allocator_type getAllocator() const
+	{
+		return allocator_type();
+	}
+
+	inline uint64_t getGeneration() const
+	{
+		return mHeader->generation.load( std::memory_order_acquire );
+	}
+
+	inline size_t maxSize() const
+	{
+		return ( std::numeric_limits<size_t>::max() - MappedRingHeader::kDataOffset ) / sizeof( T );
+	}
+
+	inline bool empty() const
+	{
+		return mHeader->size == 0;
+	}
+
+	inline bool isFileBacked() const
+	{
+		return mFile >= 0;
+	}
+
+	inline size_t size() const
+	{
+		return (size_t)mHeader->size;
+	}
+
+	inline container_type& container()
+	{
+		return *this;
+	}
+
+	inline const container_type& container() const
+	{
+		return *this;
+	}
+
+	inline WindowT<T> getWindow()
+	{
+		size_t head = (size_t)mHeader->head;
+		size_t size = (size_t)mHeader->size;
+		if ( size == 0 ) {
+			return WindowT<T>();
+		}
+		size_t count = size < capacity() - head ? size : capacity() - head;
+		return WindowT<T>( SpanT<T>( mData + head, count ), SpanT<T>( mData, size - count ) );
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		size_t head = (size_t)mHeader->head;
+		size_t size = (size_t)mHeader->size;
+		if ( size == 0 ) {
+			return WindowT<const T>();
+		}
+		size_t count = size < capacity() - head ? size : capacity() - head;
+		return WindowT<const T>( SpanT<const T>( mData + head, count ), SpanT<const T>( mData, size - count ) );
+	}
+
+	template<typename Iter>
+	inline void append( Iter first, Iter last )
+	{
+		size_t count = std::distance( first, last );
+		if ( size() + count > capacity() ) {
+			reallocate( size() + count > capacity() * 2 ? size() + count : capacity() * 2 );
+		}
+		beginWrite();
+		size_t tail	= wrap( mHeader->head + mHeader->size );
+		size_t n	= count < capacity() - tail ? count : capacity() - tail;
+		Iter mid	= first;
+		std::advance( mid, n );
+		std::copy( first, mid, mData + tail );
+		std::copy( mid, last, mData );
+		mHeader->size += count;
+		endWrite();
+	}
+
+	inline void clear()
+	{
+		beginWrite();
+		mHeader->head = 0;
+		mHeader->size = 0;
+		endWrite();
+	}
+
+	inline void erase( size_t index )
+	{
+		beginWrite();
+		if ( index < size() / 2 ) {
+			for ( size_t i = index; i > 0; --i ) {
+				( *this )[ i ] = ( *this )[ i - 1 ];
+			}
+			mHeader->head = wrap( mHeader->head + 1 );
+		} else {
+			for ( size_t i = index; i + 1 < size(); ++i ) {
+				( *this )[ i ] = ( *this )[ i + 1 ];
+			}
+		}
+		--mHeader->size;
+		endWrite();
+	}
+
+	inline void eraseFront( size_t count )
+	{
+		beginWrite();
+		mHeader->head = wrap( mHeader->head + count );
+		mHeader->size -= count;
+		endWrite();
+	}
+
+	// Schedules the mapped pages to be written to the file; wait blocks until they are
+	inline void flush( bool wait = false )
+	{
+		if ( mFile >= 0 && ::msync( mHeader, mMapSize, wait ? MS_SYNC : MS_ASYNC ) != 0 ) {
+			fail( "MappedRingStorageT: msync" );
+		}
+	}
+
+	inline void insert( size_t index, const T& v )
+	{
+		T value( v );
+		if ( size() == capacity() ) {
+			reallocate( capacity() == 0 ? 1 : capacity() * 2 );
+		}
+		beginWrite();
+		if ( index < size() / 2 ) {
+			mHeader->head = wrap( mHeader->head + capacity() - 1 );
+			++mHeader->size;
+			for ( size_t i = 0; i < index; ++i ) {
+				( *this )[ i ] = ( *this )[ i + 1 ];
+			}
+		} else {
+			++mHeader->size;
+			for ( size_t i = size() - 1; i > index; --i ) {
+				( *this )[ i ] = ( *this )[ i - 1 ];
+			}
+		}
+		( *this )[ index ] = value;
+		endWrite();
+	}
+
+	inline void padFront( size_t count )
+	{
+		reserve( size() + count );
+		beginWrite();
+		mHeader->head = wrap( mHeader->head + capacity() - count );
+		mHeader->size += count;
+		for ( size_t i = 0; i < count; ++i ) {
+			( *this )[ i ] = T();
+		}
+		endWrite();
+	}
+
+	inline void pushBack( const T& v )
+	{
+		if ( size() == capacity() ) {
+			// v may be a sample of the mapping that reallocate() replaces
+			T value( v );
+			reallocate( capacity() == 0 ? 1 : capacity() * 2 );
+			beginWrite();
+			mData[ wrap( mHeader->head + mHeader->size ) ] = value;
+		} else {
+			beginWrite();
+			mData[ wrap( mHeader->head + mHeader->size ) ] = v;
+		}
+		++mHeader->size;
+		endWrite();
+	}
+
+	inline void pushBack( T&& v )
+	{
+		pushBack( static_cast<const T&>( v ) );
+	}
+
+	// Grows by at least half, like RingStorageT, so each growth rewrites the mapping less often
+	inline void reserve( size_t capacity )
+	{
+		if ( capacity > this->capacity() ) {
+			size_t grown = this->capacity() + this->capacity() / 2;
+			reallocate( capacity > grown ? capacity : grown );
+		}
+	}
+
+	inline void shrinkToFit()
+	{
+		if ( size() < capacity() ) {
+			reallocate( size() );
+		}
+	}
+protected:
+	T*					mData;
+	int					mFile;
+	MappedRingHeader*	mHeader;
+	size_t				mMapSize;
+
+	inline size_t wrap( uint64_t index ) const
+	{
+		return (size_t)( index >= mHeader->capacity ? index - mHeader->capacity : index );
+	}
+
+	inline void beginWrite()
+	{
+		mHeader->generation.store( mHeader->generation.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+	}
+
+	inline void endWrite()
+	{
+		mHeader->generation.store( mHeader->generation.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+	}
+
+	static inline void fail( const char* what )
+	{
+		static_cast<void>( what );	// Unused when SAMPLING_THROW aborts
+		SAMPLING_THROW( std::system_error( errno, std::generic_category(), what ) );
+	}
+
+	inline void init( size_t capacity )
+	{
+		mHeader->magic		= MappedRingHeader::kMagic;
+		mHeader->version	= MappedRingHeader::kVersion;
+		mHeader->sampleSize	= sizeof( T );
+		mHeader->capacity	= capacity;
+		mHeader->head		= 0;
+		mHeader->size		= 0;
+		mHeader->generation.store( 0, std::memory_order_release );
+	}
+
+	/*
+	 * Whether the mapped file holds a ring of T whose header fits the file.
+	 * The generation is not checked: a writer that crashed between
+	 * beginWrite() and endWrite() leaves it odd, and resuming the ring is the
+	 * recovery point that makes it even again.
+	 */
+	inline bool isValid( size_t fileSize ) const
+	{
+		return mHeader->magic == MappedRingHeader::kMagic && mHeader->version == MappedRingHeader::kVersion &&
+			mHeader->sampleSize == sizeof( T ) && mHeader->head < ( mHeader->capacity > 0 ? mHeader->capacity : 1 ) &&
+			mHeader->size <= mHeader->capacity && MappedRingHeader::kDataOffset + mHeader->capacity * sizeof( T ) <= fileSize;
+	}
+
+	// Maps the header and capacity samples of the file, or anonymous memory
+	inline void map( size_t capacity )
+	{
+		mMapSize = MappedRingHeader::kDataOffset + capacity * sizeof( T );
+		void* base = mFile >= 0 ? ::mmap( nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0 ) :
+			::mmap( nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if ( base == MAP_FAILED ) {
+			mMapSize = 0;
+			fail( "MappedRingStorageT: mmap" );
+		}
+		mHeader	= static_cast<MappedRingHeader*>( base );
+		mData	= reinterpret_cast<T*>( static_cast<char*>( base ) + MappedRingHeader::kDataOffset );
+	}
+
+	// Rewrites the ring, oldest sample first, into a mapping of capacity samples
+	inline void reallocate( size_t capacity )
+	{
+		std::vector<T> samples( begin(), end() );
+		uint64_t generation = mHeader->generation.load( std::memory_order_relaxed );
+		mHeader->generation.store( generation + 1, std::memory_order_release );
+		if ( mFile >= 0 ) {
+			if ( capacity > this->capacity() ) {
+				resize( capacity );
+			}
+			unmap();
+			if ( capacity < samples.size() ) {
+				capacity = samples.size();
+			}
+			map( capacity );
+			if ( capacity < mHeader->capacity ) {
+				resize( capacity );
+			}
+		} else {
+			unmap();
+			map( capacity );
+			mHeader->magic		= MappedRingHeader::kMagic;
+			mHeader->version	= MappedRingHeader::kVersion;
+			mHeader->sampleSize	= sizeof( T );
+		}
+		std::copy( samples.begin(), samples.end(), mData );
+		mHeader->capacity	= capacity;
+		mHeader->head		= 0;
+		mHeader->size		= samples.size();
+		mHeader->generation.store( generation + 2, std::memory_order_release );
+	}
+
+	inline void release()
+	{
+		unmap();
+		if ( mFile >= 0 ) {
+			::close( mFile );
+			mFile = -1;
+		}
+	}
+
+	inline void resize( size_t capacity )
+	{
+		if ( ::ftruncate( mFile, (off_t)( MappedRingHeader::kDataOffset + capacity * sizeof( T ) ) ) != 0 ) {
+			fail( "MappedRingStorageT: ftruncate" );
+		}
+	}
+
+	inline void unmap()
+	{
+		if ( mHeader != nullptr ) {
+			::munmap( mHeader, mMapSize );
+			mData		= nullptr;
+			mHeader		= nullptr;
+			mMapSize	= 0;
+		}
+	}
+};
+
+/*
+ * Read-only, cross-process access to a ring that a MappedRingStorageT is
+ * writing, e.g. from an offline analyzer. snapshot() copies the window out
+ * seqlock-style, retrying whenever the writer changed the ring mid-copy,
+ * and follows the file when the writer grows it.
+ */
+template<typename T>
+class MappedRingReaderT
+{
+	static_assert( std::is_trivially_copyable<T>::value, "MappedRingReaderT requires a trivially copyable sample type" );
+public:
+	explicit MappedRingReaderT( const char* path )
+		: mFile( -1 ), mHeader( nullptr ), mMapSize( 0 )
+	{
+		mFile = ::open( path, O_RDONLY );
+		if ( mFile < 0 ) {
+			fail( "MappedRingReaderT: open" );
+		}
+		remap();
+		if ( mHeader->magic != MappedRingHeader::kMagic || mHeader->version != MappedRingHeader::kVersion ||
+			mHeader->sampleSize != sizeof( T ) ) {
+			release();
+			errno = EINVAL;
+			fail( "MappedRingReaderT: not a ring of this sample type" );
+		}
+	}
+
+	MappedRingReaderT( const MappedRingReaderT& ) = delete;
+	MappedRingReaderT& operator=( const MappedRingReaderT& ) = delete;
+
+	~MappedRingReaderT()
+	{
+		release();
+	}
+
+	inline uint64_t getGeneration() const
+	{
+		return mHeader->generation.load( std::memory_order_acquire );
+	}
+
+	// Copies the window, oldest first, into out and returns its size
+	inline size_t snapshot( std::vector<T>& out )
+	{
+		for ( ;; ) {
+			uint64_t generation = mHeader->generation.load( std::memory_order_acquire );
+			if ( generation & 1 ) {
+				std::this_thread::yield();
+				continue;
+			}
+			uint64_t capacity	= mHeader->capacity;
+			uint64_t head		= mHeader->head;
+			uint64_t size		= mHeader->size;
+			if ( MappedRingHeader::kDataOffset + capacity * sizeof( T ) > mMapSize ) {
+				remap();
+				continue;
+			}
+			if ( size > capacity || ( capacity > 0 && head >= capacity ) ) {
+				continue;
+			}
+			const T* data = reinterpret_cast<const T*>( reinterpret_cast<const char*>( mHeader ) + MappedRingHeader::kDataOffset );
+			size_t count = (size_t)( size < capacity - head ? size : capacity - head );
+			out.resize( (size_t)size );
+			std::copy( data + head, data + head + count, out.begin() );
+			std::copy( data, data + ( size - count ), out.begin() + count );
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if ( mHeader->generation.load( std::memory_order_relaxed ) == generation ) {
+				return out.size();
+			}
+		}
+	}
+protected:
+	int							mFile;
+	const MappedRingHeader*		mHeader;
+	size_t						mMapSize;
+
+	static inline void fail( const char* what )
+	{
+		static_cast<void>( what );	// Unused when SAMPLING_THROW aborts
+		SAMPLING_THROW( std::system_error( errno, std::generic_category(), what ) );
+	}
+
+	inline void release()
+	{
+		if ( mHeader != nullptr ) {
+			::munmap( const_cast<MappedRingHeader*>( mHeader ), mMapSize );
+			mHeader = nullptr;
+		}
+		if ( mFile >= 0 ) {
+			::close( mFile );
+			mFile = -1;
+		}
+	}
+
+	// Maps the whole file as it is now
+	inline void remap()
+	{
+		struct stat info;
+		if ( ::fstat( mFile, &info ) != 0 ) {
+			fail( "MappedRingReaderT: fstat" );
+		}
+		if ( (size_t)info.st_size < MappedRingHeader::kDataOffset ) {
+			errno = EINVAL;
+			fail( "MappedRingReaderT: file too small" );
+		}
+		if ( mHeader != nullptr ) {
+			::munmap( const_cast<MappedRingHeader*>( mHeader ), mMapSize );
+			mHeader = nullptr;
+		}
+		mMapSize = (size_t)info.st_size;
+		void* base = ::mmap( nullptr, mMapSize, PROT_READ, MAP_SHARED, mFile, 0 );
+		if ( base == MAP_FAILED ) {
+			mMapSize = 0;
+			fail( "MappedRingReaderT: mmap" );
+		}
+		mHeader = static_cast<const MappedRingHeader*>( base );
+	}
+};
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A std::function replacement that keeps its callable in an inline buffer
+ * of Capacity bytes. Callables that fit (and can be moved without
+ * throwing) are neither heap-allocated nor copied through one, and calling
+ * is one indirect call with no virtual dispatch. Larger callables still
+ * work and are held on the heap. A null std::function or function pointer
+ * produces an empty InplaceFunctionT, which compares equal to nullptr.
+ */
+template<typename Sig, size_t Capacity = 48>
+class InplaceFunctionT;
+
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunctionT<R( Args... ), Capacity>
+{
+	template<typename F>
+	struct IsInplace
+	{
+		static const bool value = sizeof( F ) <= Capacity && alignof( F ) <= alignof( std::max_align_t ) &&
+			std::is_nothrow_move_constructible<F>::value;
+	};
+public:
+	static const size_t kCapacity = Capacity;
+
+	InplaceFunctionT()
+		: mInvoke( nullptr ), mManage( nullptr )
+	{
+	}
+
+	InplaceFunctionT( std::nullptr_t )
+		: mInvoke( nullptr ), mManage( nullptr )
+	{
+	}
+
+	InplaceFunctionT( const InplaceFunctionT& rhs )
+		: mInvoke( rhs.mInvoke ), mManage( rhs.mManage )
+	{
+		if ( mManage != nullptr ) {
+			mManage( OP_COPY, &mStorage, &rhs.mStorage );
+		}
+	}
+
+	InplaceFunctionT( InplaceFunctionT&& rhs ) noexcept
+		: mInvoke( rhs.mInvoke ), mManage( rhs.mManage )
+	{
+		if ( mManage != nullptr ) {
+			mManage( OP_MOVE, &mStorage, &rhs.mStorage );
+			rhs.mInvoke = nullptr;
+			rhs.mManage = nullptr;
+		}
+	}
+
+	template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, InplaceFunctionT>::value>::type>
+	InplaceFunctionT( F&& func )
+		: mInvoke( nullptr ), mManage( nullptr )
+	{
+		typedef typename std::decay<F>::type Func;
+		if ( !isNull( func ) ) {
+			construct<Func>( std::forward<F>( func ), std::integral_constant<bool, IsInplace<Func>::value>() );
+			mInvoke = &Ops<Func, IsInplace<Func>::value>::invoke;
+			mManage = &Ops<Func, IsInplace<Func>::value>::manage;
+		}
+	}
+
+	~InplaceFunctionT()
+	{
+		reset();
+	}
+
+	InplaceFunctionT& operator=( const InplaceFunctionT& rhs )
+	{
+		if ( this != &rhs ) {
+			*this = InplaceFunctionT( rhs );
+		}
+		return *this;
+	}
+
+	InplaceFunctionT& operator=( InplaceFunctionT&& rhs ) noexcept
+	{
+		if ( this != &rhs ) {
+			reset();
+			if ( rhs.mManage != nullptr ) {
+				rhs.mManage( OP_MOVE, &mStorage, &rhs.mStorage );
+				mInvoke		= rhs.mInvoke;
+				mManage		= rhs.mManage;
+				rhs.mInvoke	= nullptr;
+				rhs.mManage	= nullptr;
+			}
+		}
+		return *this;
+	}
+
+	InplaceFunctionT& operator=( std::nullptr_t )
+	{
+		reset();
+		return *this;
+	}
+
+	template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, InplaceFunctionT>::value>::type>
+	InplaceFunctionT& operator=( F&& func )
+	{
+		return *this = InplaceFunctionT( std::forward<F>( func ) );
+	}
+
+	inline R operator()( Args... args ) const
+	{
+		return mInvoke( &mStorage, std::forward<Args>( args )... );
+	}
+
+	inline explicit operator bool() const
+	{
+		return mInvoke != nullptr;
+	}
+
+	inline bool operator==( std::nullptr_t ) const
+	{
+		return mInvoke == nullptr;
+	}
+
+	inline bool operator!=( std::nullptr_t ) const
+	{
+		return mInvoke != nullptr;
+	}
+
+	// True for a null std::function or function pointer
+	template<typename F>
+	static inline bool isNull( const F& )
+	{
+		return false;
+	}
+
+	template<typename S>
+	static inline bool isNull( const std::function<S>& func )
+	{
+		return !func;
+	}
+
+	template<typename P>
+	static inline bool isNull( P* func )
+	{
+		return func == nullptr;
+	}
+
+	// True if the callable is held in the inline buffer (or there is none)
+	inline bool isInplace() const
+	{
+		return mManage == nullptr || mManage( OP_QUERY, nullptr, nullptr );
+	}
+protected:
+	enum Op
+	{
+		OP_COPY, OP_DESTROY, OP_MOVE, OP_QUERY
+	};
+
+	typedef typename std::aligned_storage<Capacity, alignof( std::max_align_t )>::type	Storage;
+	typedef R	( *Invoke )( void*, Args&&... );
+	typedef bool	( *Manage )( Op, void*, const void* );
+
+	template<typename F, bool Inplace>
+	struct Ops
+	{
+		static R invoke( void* storage, Args&&... args )
+		{
+			return ( *static_cast<F*>( storage ) )( std::forward<Args>( args )... );
+		}
+
+		static bool manage( Op op, void* dst, const void* src )
+		{
+			switch ( op ) {
+			case OP_COPY:
+				new ( dst ) F( *static_cast<const F*>( src ) );
+				break;
+			case OP_DESTROY:
+				static_cast<F*>( dst )->~F();
+				break;
+			case OP_MOVE:
+				new ( dst ) F( std::move( *static_cast<F*>( const_cast<void*>( src ) ) ) );
+				static_cast<F*>( const_cast<void*>( src ) )->~F();
+				break;
+			case OP_QUERY:
+				break;
+			}
+			return true;
+		}
+	};
+
+	template<typename F>
+	struct Ops<F, false>
+	{
+		static R invoke( void* storage, Args&&... args )
+		{
+			return ( **static_cast<F**>( storage ) )( std::forward<Args>( args )... );
+		}
+
+		static bool manage( Op op, void* dst, const void* src )
+		{
+			switch ( op ) {
+			case OP_COPY:
+				new ( dst ) F*( new F( **static_cast<F* const*>( src ) ) );
+				break;
+			case OP_DESTROY:
+				delete *static_cast<F**>( dst );
+				break;
+			case OP_MOVE:
+				new ( dst ) F*( *static_cast<F* const*>( src ) );
+				break;
+			case OP_QUERY:
+				break;
+			}
+			return false;
+		}
+	};
+
+	mutable Storage	mStorage;
+	Invoke			mInvoke;
+	Manage			mManage;
+
+	template<typename Func, typename F>
+	inline void construct( F&& func, std::true_type )
+	{
+		new ( &mStorage ) Func( std::forward<F>( func ) );
+	}
+
+	template<typename Func, typename F>
+	inline void construct( F&& func, std::false_type )
+	{
+		new ( &mStorage ) Func*( new Func( std::forward<F>( func ) ) );
+	}
+
+	inline void reset()
+	{
+		if ( mManage != nullptr ) {
+			mManage( OP_DESTROY, &mStorage, nullptr );
+			mInvoke = nullptr;
+			mManage = nullptr;
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A flat, index-addressed process registry with a std::map-like interface.
+ * The ID is the slot index, so lookup is a bounds check and a flag test
+ * rather than a tree walk. IDs are expected to be small and dense (an enum);
+ * the table grows to the largest ID in use. Iteration visits occupied slots
+ * in ascending ID order, yielding entries with first (ID) and second (process).
+ */
+template<typename F, typename A = std::allocator<F> >
+class ProcessTableT
+{
+public:
+	struct Entry
+	{
+		size_t	first;
+		F		second;
+	};
+
+	template<typename Table, typename E>
+	class IteratorT
+	{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef E							value_type;
+		typedef ptrdiff_t					difference_type;
+		typedef E*							pointer;
+		typedef E&							reference;
+
+		IteratorT( Table* table, size_t index )
+			: mIndex( index ), mTable( table )
+		{
+			skip();
+		}
+
+		inline reference operator*() const
+		{
+			return mTable->mEntries[ mIndex ];
+		}
+
+		inline pointer operator->() const
+		{
+			return &mTable->mEntries[ mIndex ];
+		}
+
+		inline IteratorT& operator++()
+		{
+			++mIndex;
+			skip();
+			return *this;
+		}
+
+		inline IteratorT operator++( int )
+		{
+			IteratorT it = *this;
+			++*this;
+			return it;
+		}
+
+		inline bool operator==( const IteratorT& rhs ) const
+		{
+			return mIndex == rhs.mIndex;
+		}
+
+		inline bool operator!=( const IteratorT& rhs ) const
+		{
+			return mIndex != rhs.mIndex;
+		}
+	protected:
+		size_t	mIndex;
+		Table*	mTable;
+
+		inline void skip()
+		{
+			while ( mIndex < mTable->mUsed.size() && !mTable->mUsed[ mIndex ] ) {
+				++mIndex;
+			}
+		}
+	};
+
+	typedef IteratorT<ProcessTableT, Entry>				iterator;
+	typedef IteratorT<const ProcessTableT, const Entry>	const_iterator;
+
+	explicit ProcessTableT( const A& allocator = A() )
+		: mEntries( EntryAllocator( allocator ) ), mSize( 0 ), mUsed( FlagAllocator( allocator ) )
+	{
+	}
+
+	inline F& operator[]( size_t index )
+	{
+		if ( index >= mEntries.size() ) {
+			size_t first = mEntries.size();
+			mEntries.resize( index + 1 );
+			mUsed.resize( index + 1, 0 );
+			for ( size_t i = first; i <= index; ++i ) {
+				mEntries[ i ].first = i;
+			}
+		}
+		if ( !mUsed[ index ] ) {
+			mUsed[ index ] = 1;
+			++mSize;
+		}
+		return mEntries[ index ].second;
+	}
+
+	inline F& at( size_t index )
+	{
+		F* func = get( index );
+		if ( func == nullptr ) {
+			SAMPLING_THROW( std::out_of_range( "ProcessTableT::at" ) );
+		}
+		return *func;
+	}
+
+	inline const F& at( size_t index ) const
+	{
+		const F* func = get( index );
+		if ( func == nullptr ) {
+			SAMPLING_THROW( std::out_of_range( "ProcessTableT::at" ) );
+		}
+		return *func;
+	}
+
+	inline iterator begin()
+	{
+		return iterator( this, 0 );
+	}
+
+	inline const_iterator begin() const
+	{
+		return const_iterator( this, 0 );
+	}
+
+	inline iterator end()
+	{
+		return iterator( this, mUsed.size() );
+	}
+
+	inline const_iterator end() const
+	{
+		return const_iterator( this, mUsed.size() );
+	}
+
+	inline void clear()
+	{
+		mEntries.clear();
+		mUsed.clear();
+		mSize = 0;
+	}
+
+	inline size_t count( size_t index ) const
+	{
+		return index < mUsed.size() && mUsed[ index ] ? 1 : 0;
+	}
+
+	inline bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	inline size_t erase( size_t index )
+	{
+		if ( count( index ) == 0 ) {
+			return 0;
+		}
+		mEntries[ index ].second	= F();
+		mUsed[ index ]				= 0;
+		--mSize;
+		return 1;
+	}
+
+	inline iterator find( size_t index )
+	{
+		return count( index ) > 0 ? iterator( this, index ) : end();
+	}
+
+	inline const_iterator find( size_t index ) const
+	{
+		return count( index ) > 0 ? const_iterator( this, index ) : end();
+	}
+
+	// Single lookup; returns nullptr if nothing is registered under index
+	inline F* get( size_t index )
+	{
+		return count( index ) > 0 ? &mEntries[ index ].second : nullptr;
+	}
+
+	inline const F* get( size_t index ) const
+	{
+		return count( index ) > 0 ? &mEntries[ index ].second : nullptr;
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+protected:
+	typedef RebindAllocT<A, Entry>			EntryAllocator;
+	typedef RebindAllocT<A, unsigned char>	FlagAllocator;
+
+	std::vector<Entry, EntryAllocator>			mEntries;
+	size_t										mSize;
+	std::vector<unsigned char, FlagAllocator>	mUsed;
+};
+
+/*
+ * The ID of a process that returns R instead of the sampler's Y. Typed
+ * processes have IDs of their own, apart from the Y ones, and are
+ * declared the way enum IDs are:
+ *
+ *	const ProcessHandleT<Histogram> ID_HISTOGRAM( 0 );
+ *	const ProcessHandleT<std::vector<float> > ID_SPECTRUM( 1 );
+ */
+template<typename R>
+class ProcessHandleT
+{
+public:
+	typedef R result_type;
+
+	explicit ProcessHandleT( size_t index = 0 )
+		: mIndex( index )
+	{
+	}
+
+	inline size_t getIndex() const
+	{
+		return mIndex;
+	}
+protected:
+	size_t mIndex;
+};
+
+// A distinct address per type, to check a handle against the process it names
+template<typename R>
+struct TypeTagT
+{
+	static const char kId;
+};
+
+template<typename R>
+const char TypeTagT<R>::kId = 0;
+
+/*
+ * When a trigger fires: TRIGGER_RISING when a process's value reaches the
+ * threshold from below, TRIGGER_FALLING when it drops below it,
+ * TRIGGER_CROSSING for either, and TRIGGER_RATE when the value moved by at
+ * least the threshold since the trigger last evaluated it.
+ */
+enum TriggerCondition
+{
+	TRIGGER_CROSSING, TRIGGER_FALLING, TRIGGER_RATE, TRIGGER_RISING
+};
+
+// What a trigger's callback is told
+template<typename Y>
+struct TriggerEventT
+{
+	size_t	trigger;	// The ID trigger() returned
+	size_t	index;		// The process that was evaluated
+	Y		previous;
+	Y		value;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Accumulators are incremental statistics that the sampler keeps up to date
+ * as samples enter and leave the window, so reading them is O(1) instead of
+ * a rescan. push() receives the newest sample and pop() the oldest one as
+ * it is evicted. Edits in the middle of the window (insertSample(),
+ * eraseSample(), padding) clear the accumulator and feed it the window again.
+ */
+template<typename T, typename Y>
+class AccumulatorT
+{
+public:
+	virtual ~AccumulatorT()
+	{
+	}
+
+	virtual AccumulatorT*	clone() const = 0;
+	virtual void			clear() = 0;
+	virtual Y				getValue() const = 0;
+	virtual void			pop( const T& v ) = 0;
+	virtual void			push( const T& v ) = 0;
+};
+
+template<typename T, typename Y = T>
+class RunningSumT : public AccumulatorT<T, Y>
+{
+public:
+	RunningSumT()
+		: mSum( Y() )
+	{
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new RunningSumT( *this );
+	}
+
+	inline void clear()
+	{
+		mSum = Y();
+	}
+
+	inline Y getValue() const
+	{
+		return mSum;
+	}
+
+	inline void pop( const T& v )
+	{
+		mSum -= (Y)v;
+	}
+
+	inline void push( const T& v )
+	{
+		mSum += (Y)v;
+	}
+protected:
+	Y mSum;
+};
+
+template<typename T, typename Y = T>
+class RunningMeanT : public AccumulatorT<T, Y>
+{
+public:
+	RunningMeanT()
+		: mCount( 0 ), mSum( Y() )
+	{
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new RunningMeanT( *this );
+	}
+
+	inline void clear()
+	{
+		mCount	= 0;
+		mSum	= Y();
+	}
+
+	inline Y getValue() const
+	{
+		return mCount > 0 ? mSum / (Y)mCount : Y();
+	}
+
+	inline void pop( const T& v )
+	{
+		--mCount;
+		mSum -= (Y)v;
+	}
+
+	inline void push( const T& v )
+	{
+		++mCount;
+		mSum += (Y)v;
+	}
+protected:
+	size_t	mCount;
+	Y		mSum;
+};
+
+/*
+ * Welford's running variance, with the matching update for removing a
+ * sample. Returns the population variance unless constructed with
+ * unbiased = true, in which case it divides by n - 1.
+ */
+template<typename T, typename Y = T>
+class RunningVarianceT : public AccumulatorT<T, Y>
+{
+public:
+	RunningVarianceT( bool unbiased = false )
+		: mCount( 0 ), mM2( Y() ), mMean( Y() ), mUnbiased( unbiased )
+	{
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new RunningVarianceT( *this );
+	}
+
+	inline void clear()
+	{
+		mCount	= 0;
+		mM2		= Y();
+		mMean	= Y();
+	}
+
+	inline Y getMean() const
+	{
+		return mMean;
+	}
+
+	inline Y getValue() const
+	{
+		size_t n = mUnbiased ? mCount - 1 : mCount;
+		return mCount > 1 ? mM2 / (Y)n : Y();
+	}
+
+	inline void pop( const T& v )
+	{
+		if ( mCount <= 1 ) {
+			clear();
+			return;
+		}
+		Y x		= (Y)v;
+		Y d		= x - mMean;
+		--mCount;
+		mMean	-= d / (Y)mCount;
+		mM2		-= d * ( x - mMean );
+	}
+
+	inline void push( const T& v )
+	{
+		Y x		= (Y)v;
+		Y d		= x - mMean;
+		++mCount;
+		mMean	+= d / (Y)mCount;
+		mM2		+= d * ( x - mMean );
+	}
+protected:
+	size_t	mCount;
+	Y		mM2;
+	Y		mMean;
+	bool	mUnbiased;
+};
+
+/*
+ * Sliding minimum or maximum over the window using a monotonic deque. Each
+ * sample is pushed and popped at most once, so updates are amortized O(1).
+ * Compare is std::less for a minimum and std::greater for a maximum.
+ */
+template<typename T, typename Y, typename Compare>
+class SlidingExtremumT : public AccumulatorT<T, Y>
+{
+public:
+	SlidingExtremumT()
+		: mNumPopped( 0 ), mNumPushed( 0 )
+	{
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new SlidingExtremumT( *this );
+	}
+
+	inline void clear()
+	{
+		mDeque.clear();
+		mNumPopped	= 0;
+		mNumPushed	= 0;
+	}
+
+	inline Y getValue() const
+	{
+		return mDeque.empty() ? Y() : (Y)mDeque.front().second;
+	}
+
+	inline void pop( const T& )
+	{
+		if ( !mDeque.empty() && mDeque.front().first == mNumPopped ) {
+			mDeque.pop_front();
+		}
+		++mNumPopped;
+	}
+
+	inline void push( const T& v )
+	{
+		while ( !mDeque.empty() && !mCompare( mDeque.back().second, v ) ) {
+			mDeque.pop_back();
+		}
+		mDeque.push_back( std::make_pair( mNumPushed, v ) );
+		++mNumPushed;
+	}
+protected:
+	Compare								mCompare;
+	std::deque<std::pair<size_t, T> >	mDeque;
+	size_t								mNumPopped;
+	size_t								mNumPushed;
+};
+
+template<typename T, typename Y = T>
+using SlidingMinT = SlidingExtremumT<T, Y, std::less<T> >;
+
+template<typename T, typename Y = T>
+using SlidingMaxT = SlidingExtremumT<T, Y, std::greater<T> >;
+
+/*
+ * Sliding quantile over the window from a fixed histogram of numBins bins
+ * spanning [ low, high ). Counts are kept in a Fenwick tree, so push, pop
+ * and any quantile query are O( log numBins ) with memory independent of
+ * the window size. Results are interpolated within a bin and accurate to
+ * half a bin width, ( high - low ) / numBins / 2; samples outside the
+ * range count toward the first or last bin. getValue() returns the
+ * quantile given at construction, e.g. 0.5 for the median, and
+ * getQuantile() answers any other from the same histogram.
+ */
+template<typename T, typename Y = T>
+class SlidingQuantileT : public AccumulatorT<T, Y>
+{
+public:
+	SlidingQuantileT( double quantile, double low, double high, size_t numBins = 1024 )
+		: mCount( 0 ), mCounts( numBins < 1 ? 1 : numBins, 0 ), mLow( low ), mQuantile( quantile ),
+		mTree( mCounts.size() + 1, 0 )
+	{
+		mWidth = high > low ? ( high - low ) / mCounts.size() : 1.0;
+		mStep = 1;
+		while ( mStep * 2 <= mCounts.size() ) {
+			mStep *= 2;
+		}
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new SlidingQuantileT( *this );
+	}
+
+	inline void clear()
+	{
+		std::fill( mCounts.begin(), mCounts.end(), 0 );
+		std::fill( mTree.begin(), mTree.end(), 0 );
+		mCount = 0;
+	}
+
+	// Number of window samples in bin
+	inline size_t getBinCount( size_t bin ) const
+	{
+		return mCounts[ bin ];
+	}
+
+	inline size_t getCount() const
+	{
+		return mCount;
+	}
+
+	inline size_t getNumBins() const
+	{
+		return mCounts.size();
+	}
+
+	// quantile in [ 0, 1 ]; returns Y() for an empty window
+	inline Y getQuantile( double quantile ) const
+	{
+		if ( mCount == 0 ) {
+			return Y();
+		}
+		quantile = quantile < 0.0 ? 0.0 : ( quantile > 1.0 ? 1.0 : quantile );
+		size_t rank = (size_t)( quantile * ( mCount - 1 ) );
+
+		// Descend the tree to the bin holding the sample of that rank
+		size_t bin = 0;
+		size_t remaining = rank;
+		for ( size_t step = mStep; step > 0; step >>= 1 ) {
+			if ( bin + step <= mCounts.size() && mTree[ bin + step ] <= remaining ) {
+				bin			+= step;
+				remaining	-= mTree[ bin ];
+			}
+		}
+		double offset = ( remaining + 0.5 ) / mCounts[ bin ];
+		return (Y)( mLow + ( bin + offset ) * mWidth );
+	}
+
+	inline Y getValue() const
+	{
+		return getQuantile( mQuantile );
+	}
+
+	inline void pop( const T& v )
+	{
+		size_t bin = getBin( v );
+		--mCounts[ bin ];
+		--mCount;
+		for ( size_t i = bin + 1; i < mTree.size(); i += i & ( ~i + 1 ) ) {
+			--mTree[ i ];
+		}
+	}
+
+	inline void push( const T& v )
+	{
+		size_t bin = getBin( v );
+		++mCounts[ bin ];
+		++mCount;
+		for ( size_t i = bin + 1; i < mTree.size(); i += i & ( ~i + 1 ) ) {
+			++mTree[ i ];
+		}
+	}
+protected:
+	size_t				mCount;
+	std::vector<size_t>	mCounts;
+	double				mLow;
+	double				mQuantile;
+	size_t				mStep;
+	std::vector<size_t>	mTree;
+	double				mWidth;
+
+	inline size_t getBin( const T& v ) const
+	{
+		double x = ( (double)v - mLow ) / mWidth;
+		if ( !( x >= 1.0 ) ) {
+			return 0;
+		}
+		return x >= (double)mCounts.size() ? mCounts.size() - 1 : (size_t)x;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A kernel is a process written as a fold over the window. begin() resets
+ * it, update() receives consecutive blocks of samples oldest to newest, and
+ * end() returns the result. Because kernels never touch the sampler
+ * themselves, runProcesses() and runAll() can feed one block to every
+ * requested kernel while it is still in cache, so K reductions share a
+ * single traversal of the window.
+ */
+template<typename T, typename Y>
+class KernelT
+{
+public:
+	virtual ~KernelT()
+	{
+	}
+
+	virtual void	begin() = 0;
+	virtual KernelT*	clone() const = 0;
+	virtual Y		end() = 0;
+	virtual void	update( const SpanT<const T>& block ) = 0;
+};
+
+/*
+ * Builds a kernel from an initial state, a step function called as
+ * step( state, sample ) for each sample, and a finish function called as
+ * finish( state, count ) to produce the result. See makeFoldKernel().
+ */
+template<typename T, typename Y, typename A, typename Step, typename Finish>
+class FoldKernelT : public KernelT<T, Y>
+{
+public:
+	FoldKernelT( const A& init, const Step& step, const Finish& finish )
+		: mCount( 0 ), mFinish( finish ), mInit( init ), mState( init ), mStep( step )
+	{
+	}
+
+	inline void begin()
+	{
+		mCount = 0;
+		mState = mInit;
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new FoldKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return mFinish( mState, mCount );
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		for ( const T& v : block ) {
+			mStep( mState, v );
+		}
+		mCount += block.size();
+	}
+protected:
+	size_t	mCount;
+	Finish	mFinish;
+	A		mInit;
+	A		mState;
+	Step	mStep;
+};
+
+template<typename T, typename Y, typename A, typename Step, typename Finish>
+inline FoldKernelT<T, Y, A, Step, Finish> makeFoldKernel( const A& init, const Step& step, const Finish& finish )
+{
+	return FoldKernelT<T, Y, A, Step, Finish>( init, step, finish );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Built-in reductions for arithmetic sample types. Each one accepts a
+ * pointer and count, a SpanT or a two-segment WindowT. float, double and
+ * int32_t use SSE2/SSE4.1/AVX/AVX2 or NEON when the target allows it, and
+ * every other type uses a plain loop. Results accumulate in T, so narrow
+ * integer types can overflow. SIMD sums are evaluated in a different order
+ * than a serial loop, so floating point results can differ in the last bits.
+ * addInto(), maximumInto() and minimumInto() instead combine an array into
+ * an accumulator element by element, which is how SamplerBankT reduces
+ * every sampler's window at once.
+ */
+namespace reduce {
+
+template<typename T>
+struct ScalarT
+{
+	static inline T dot( const T* a, const T* b, size_t count )
+	{
+		T r = T();
+		for ( size_t i = 0; i < count; ++i ) {
+			r += a[ i ] * b[ i ];
+		}
+		return r;
+	}
+
+	static inline T maximum( const T* data, size_t count )
+	{
+		if ( count == 0 ) {
+			return T();
+		}
+		T r = data[ 0 ];
+		for ( size_t i = 1; i < count; ++i ) {
+			r = data[ i ] > r ? data[ i ] : r;
+		}
+		return r;
+	}
+
+	static inline T minimum( const T* data, size_t count )
+	{
+		if ( count == 0 ) {
+			return T();
+		}
+		T r = data[ 0 ];
+		for ( size_t i = 1; i < count; ++i ) {
+			r = data[ i ] < r ? data[ i ] : r;
+		}
+		return r;
+	}
+
+	static inline T sum( const T* data, size_t count )
+	{
+		T r = T();
+		for ( size_t i = 0; i < count; ++i ) {
+			r += data[ i ];
+		}
+		return r;
+	}
+
+	static inline void addInto( T* acc, const T* data, size_t count )
+	{
+		for ( size_t i = 0; i < count; ++i ) {
+			acc[ i ] += data[ i ];
+		}
+	}
+
+	static inline void maximumInto( T* acc, const T* data, size_t count )
+	{
+		for ( size_t i = 0; i < count; ++i ) {
+			acc[ i ] = data[ i ] > acc[ i ] ? data[ i ] : acc[ i ];
+		}
+	}
+
+	static inline void minimumInto( T* acc, const T* data, size_t count )
+	{
+		for ( size_t i = 0; i < count; ++i ) {
+			acc[ i ] = data[ i ] < acc[ i ] ? data[ i ] : acc[ i ];
+		}
+	}
+};
+
+/*
+ * Drives a lane traits struct (Register, kWidth, add, load, maximum,
+ * minimum, mul, store, zero) over a range, then folds the lanes and the
+ * scalar tail. Sums keep two registers in flight to hide add latency.
+ */
+template<typename T, typename L>
+struct SimdT
+{
+	static inline T dot( const T* a, const T* b, size_t count )
+	{
+		typename L::Register acc0 = L::zero();
+		typename L::Register acc1 = L::zero();
+		size_t i = 0;
+		for ( ; i + 2 * L::kWidth <= count; i += 2 * L::kWidth ) {
+			acc0 = L::add( acc0, L::mul( L::load( a + i ), L::load( b + i ) ) );
+			acc1 = L::add( acc1, L::mul( L::load( a + i + L::kWidth ), L::load( b + i + L::kWidth ) ) );
+		}
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			acc0 = L::add( acc0, L::mul( L::load( a + i ), L::load( b + i ) ) );
+		}
+		T r = fold( L::add( acc0, acc1 ), 0 );
+		for ( ; i < count; ++i ) {
+			r += a[ i ] * b[ i ];
+		}
+		return r;
+	}
+
+	static inline T maximum( const T* data, size_t count )
+	{
+		if ( count < L::kWidth ) {
+			return ScalarT<T>::maximum( data, count );
+		}
+		typename L::Register acc = L::load( data );
+		size_t i = L::kWidth;
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			acc = L::maximum( acc, L::load( data + i ) );
+		}
+		T r = fold( acc, 1 );
+		for ( ; i < count; ++i ) {
+			r = data[ i ] > r ? data[ i ] : r;
+		}
+		return r;
+	}
+
+	static inline T minimum( const T* data, size_t count )
+	{
+		if ( count < L::kWidth ) {
+			return ScalarT<T>::minimum( data, count );
+		}
+		typename L::Register acc = L::load( data );
+		size_t i = L::kWidth;
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			acc = L::minimum( acc, L::load( data + i ) );
+		}
+		T r = fold( acc, -1 );
+		for ( ; i < count; ++i ) {
+			r = data[ i ] < r ? data[ i ] : r;
+		}
+		return r;
+	}
+
+	static inline T sum( const T* data, size_t count )
+	{
+		typename L::Register acc0 = L::zero();
+		typename L::Register acc1 = L::zero();
+		size_t i = 0;
+		for ( ; i + 2 * L::kWidth <= count; i += 2 * L::kWidth ) {
+			acc0 = L::add( acc0, L::load( data + i ) );
+			acc1 = L::add( acc1, L::load( data + i + L::kWidth ) );
+		}
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			acc0 = L::add( acc0, L::load( data + i ) );
+		}
+		T r = fold( L::add( acc0, acc1 ), 0 );
+		for ( ; i < count; ++i ) {
+			r += data[ i ];
+		}
+		return r;
+	}
+
+	static inline void addInto( T* acc, const T* data, size_t count )
+	{
+		size_t i = 0;
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			L::store( acc + i, L::add( L::load( acc + i ), L::load( data + i ) ) );
+		}
+		ScalarT<T>::addInto( acc + i, data + i, count - i );
+	}
+
+	static inline void maximumInto( T* acc, const T* data, size_t count )
+	{
+		size_t i = 0;
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			L::store( acc + i, L::maximum( L::load( acc + i ), L::load( data + i ) ) );
+		}
+		ScalarT<T>::maximumInto( acc + i, data + i, count - i );
+	}
+
+	static inline void minimumInto( T* acc, const T* data, size_t count )
+	{
+		size_t i = 0;
+		for ( ; i + L::kWidth <= count; i += L::kWidth ) {
+			L::store( acc + i, L::minimum( L::load( acc + i ), L::load( data + i ) ) );
+		}
+		ScalarT<T>::minimumInto( acc + i, data + i, count - i );
+	}
+protected:
+	// Folds the lanes of v: op > 0 takes the maximum, op < 0 the minimum
+	// and 0 the sum
+	static inline T fold( typename L::Register v, int op )
+	{
+		T lanes[ L::kWidth ];
+		L::store( lanes, v );
+		T r = lanes[ 0 ];
+		for ( size_t i = 1; i < L::kWidth; ++i ) {
+			if ( op > 0 ) {
+				r = lanes[ i ] > r ? lanes[ i ] : r;
+			} else if ( op < 0 ) {
+				r = lanes[ i ] < r ? lanes[ i ] : r;
+			} else {
+				r += lanes[ i ];
+			}
+		}
+		return r;
+	}
+};
+
+template<typename T>
+struct KernelsT : public ScalarT<T>
+{
+};
+
+#if defined( SAMPLING_AVX )
+
+struct FloatLanes
+{
+	typedef __m256 Register;
+	static const size_t kWidth = 8;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm256_add_ps( a, b );
+	}
+
+	static inline Register load( const float* p )
+	{
+		return _mm256_loadu_ps( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm256_max_ps( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm256_min_ps( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm256_mul_ps( a, b );
+	}
+
+	static inline void store( float* p, Register v )
+	{
+		_mm256_storeu_ps( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm256_setzero_ps();
+	}
+};
+
+template<>
+struct KernelsT<float> : public SimdT<float, FloatLanes>
+{
+};
+
+struct DoubleLanes
+{
+	typedef __m256d Register;
+	static const size_t kWidth = 4;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm256_add_pd( a, b );
+	}
+
+	static inline Register load( const double* p )
+	{
+		return _mm256_loadu_pd( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm256_max_pd( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm256_min_pd( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm256_mul_pd( a, b );
+	}
+
+	static inline void store( double* p, Register v )
+	{
+		_mm256_storeu_pd( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm256_setzero_pd();
+	}
+};
+
+template<>
+struct KernelsT<double> : public SimdT<double, DoubleLanes>
+{
+};
+
+#elif defined( SAMPLING_SSE2 )
+
+struct FloatLanes
+{
+	typedef __m128 Register;
+	static const size_t kWidth = 4;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm_add_ps( a, b );
+	}
+
+	static inline Register load( const float* p )
+	{
+		return _mm_loadu_ps( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm_max_ps( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm_min_ps( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm_mul_ps( a, b );
+	}
+
+	static inline void store( float* p, Register v )
+	{
+		_mm_storeu_ps( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm_setzero_ps();
+	}
+};
+
+template<>
+struct KernelsT<float> : public SimdT<float, FloatLanes>
+{
+};
+
+struct DoubleLanes
+{
+	typedef __m128d Register;
+	static const size_t kWidth = 2;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm_add_pd( a, b );
+	}
+
+	static inline Register load( const double* p )
+	{
+		return _mm_loadu_pd( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm_max_pd( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm_min_pd( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm_mul_pd( a, b );
+	}
+
+	static inline void store( double* p, Register v )
+	{
+		_mm_storeu_pd( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm_setzero_pd();
+	}
+};
+
+template<>
+struct KernelsT<double> : public SimdT<double, DoubleLanes>
+{
+};
+
+#endif
+
+#if defined( SAMPLING_AVX2 )
+
+struct Int32Lanes
+{
+	typedef __m256i Register;
+	static const size_t kWidth = 8;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm256_add_epi32( a, b );
+	}
+
+	static inline Register load( const int32_t* p )
+	{
+		return _mm256_loadu_si256( (const __m256i*)p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm256_max_epi32( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm256_min_epi32( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm256_mullo_epi32( a, b );
+	}
+
+	static inline void store( int32_t* p, Register v )
+	{
+		_mm256_storeu_si256( (__m256i*)p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm256_setzero_si256();
+	}
+};
+
+template<>
+struct KernelsT<int32_t> : public SimdT<int32_t, Int32Lanes>
+{
+};
+
+#elif defined( SAMPLING_SSE41 )
+
+struct Int32Lanes
+{
+	typedef __m128i Register;
+	static const size_t kWidth = 4;
+
+	static inline Register add( Register a, Register b )
+	{
+		return _mm_add_epi32( a, b );
+	}
+
+	static inline Register load( const int32_t* p )
+	{
+		return _mm_loadu_si128( (const __m128i*)p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return _mm_max_epi32( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return _mm_min_epi32( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return _mm_mullo_epi32( a, b );
+	}
+
+	static inline void store( int32_t* p, Register v )
+	{
+		_mm_storeu_si128( (__m128i*)p, v );
+	}
+
+	static inline Register zero()
+	{
+		return _mm_setzero_si128();
+	}
+};
+
+template<>
+struct KernelsT<int32_t> : public SimdT<int32_t, Int32Lanes>
+{
+};
+
+#endif
+
+#if defined( SAMPLING_NEON )
+
+struct FloatLanes
+{
+	typedef float32x4_t Register;
+	static const size_t kWidth = 4;
+
+	static inline Register add( Register a, Register b )
+	{
+		return vaddq_f32( a, b );
+	}
+
+	static inline Register load( const float* p )
+	{
+		return vld1q_f32( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return vmaxq_f32( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return vminq_f32( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return vmulq_f32( a, b );
+	}
+
+	static inline void store( float* p, Register v )
+	{
+		vst1q_f32( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return vdupq_n_f32( 0.0f );
+	}
+};
+
+template<>
+struct KernelsT<float> : public SimdT<float, FloatLanes>
+{
+};
+
+struct Int32Lanes
+{
+	typedef int32x4_t Register;
+	static const size_t kWidth = 4;
+
+	static inline Register add( Register a, Register b )
+	{
+		return vaddq_s32( a, b );
+	}
+
+	static inline Register load( const int32_t* p )
+	{
+		return vld1q_s32( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return vmaxq_s32( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return vminq_s32( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return vmulq_s32( a, b );
+	}
+
+	static inline void store( int32_t* p, Register v )
+	{
+		vst1q_s32( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return vdupq_n_s32( 0 );
+	}
+};
+
+template<>
+struct KernelsT<int32_t> : public SimdT<int32_t, Int32Lanes>
+{
+};
+
+#if defined( __aarch64__ )
+
+struct DoubleLanes
+{
+	typedef float64x2_t Register;
+	static const size_t kWidth = 2;
+
+	static inline Register add( Register a, Register b )
+	{
+		return vaddq_f64( a, b );
+	}
+
+	static inline Register load( const double* p )
+	{
+		return vld1q_f64( p );
+	}
+
+	static inline Register maximum( Register a, Register b )
+	{
+		return vmaxq_f64( a, b );
+	}
+
+	static inline Register minimum( Register a, Register b )
+	{
+		return vminq_f64( a, b );
+	}
+
+	static inline Register mul( Register a, Register b )
+	{
+		return vmulq_f64( a, b );
+	}
+
+	static inline void store( double* p, Register v )
+	{
+		vst1q_f64( p, v );
+	}
+
+	static inline Register zero()
+	{
+		return vdupq_n_f64( 0.0 );
+	}
+};
+
+template<>
+struct KernelsT<double> : public SimdT<double, DoubleLanes>
+{
+};
+
+#endif
+
+#endif
+
+template<typename T>
+inline T dot( const T* a, const T* b, size_t count )
+{
+	return KernelsT<T>::dot( a, b, count );
+}
+
+template<typename T>
+inline T maximum( const T* data, size_t count )
+{
+	return KernelsT<T>::maximum( data, count );
+}
+
+template<typename T>
+inline T minimum( const T* data, size_t count )
+{
+	return KernelsT<T>::minimum( data, count );
+}
+
+template<typename T>
+inline T sum( const T* data, size_t count )
+{
+	return KernelsT<T>::sum( data, count );
+}
+
+template<typename T>
+inline T sumSquares( const T* data, size_t count )
+{
+	return KernelsT<T>::dot( data, data, count );
+}
+
+// acc[ i ] += data[ i ] for each of the count elements
+template<typename T>
+inline void addInto( T* acc, const T* data, size_t count )
+{
+	KernelsT<T>::addInto( acc, data, count );
+}
+
+// acc[ i ] = max( acc[ i ], data[ i ] ) for each of the count elements
+template<typename T>
+inline void maximumInto( T* acc, const T* data, size_t count )
+{
+	KernelsT<T>::maximumInto( acc, data, count );
+}
+
+// acc[ i ] = min( acc[ i ], data[ i ] ) for each of the count elements
+template<typename T>
+inline void minimumInto( T* acc, const T* data, size_t count )
+{
+	KernelsT<T>::minimumInto( acc, data, count );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type maximum( const SpanT<T>& samples )
+{
+	return maximum<typename std::remove_const<T>::type>( samples.data(), samples.size() );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type minimum( const SpanT<T>& samples )
+{
+	return minimum<typename std::remove_const<T>::type>( samples.data(), samples.size() );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type sum( const SpanT<T>& samples )
+{
+	return sum<typename std::remove_const<T>::type>( samples.data(), samples.size() );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type sumSquares( const SpanT<T>& samples )
+{
+	return sumSquares<typename std::remove_const<T>::type>( samples.data(), samples.size() );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type maximum( const WindowT<T>& window )
+{
+	typename std::remove_const<T>::type a = maximum( window.first() );
+	if ( window.second().empty() ) {
+		return a;
+	}
+	typename std::remove_const<T>::type b = maximum( window.second() );
+	return b > a ? b : a;
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type minimum( const WindowT<T>& window )
+{
+	typename std::remove_const<T>::type a = minimum( window.first() );
+	if ( window.second().empty() ) {
+		return a;
+	}
+	typename std::remove_const<T>::type b = minimum( window.second() );
+	return b < a ? b : a;
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type sum( const WindowT<T>& window )
+{
+	return sum( window.first() ) + sum( window.second() );
+}
+
+template<typename T>
+inline typename std::remove_const<T>::type sumSquares( const WindowT<T>& window )
+{
+	return sumSquares( window.first() ) + sumSquares( window.second() );
+}
+
+// Root mean square, in double precision for integer sample types
+template<typename T>
+inline double rms( const WindowT<T>& window )
+{
+	return window.empty() ? 0.0 : std::sqrt( (double)sumSquares( window ) / (double)window.size() );
+}
+
+} // namespace reduce
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Kernels wrapping the built-in reductions, for use with SamplerT::kernel().
+ * They only accept arithmetic sample types.
+ */
+template<typename T, typename Y = T>
+class SumKernelT : public KernelT<T, Y>
+{
+	static_assert( std::is_arithmetic<T>::value, "SumKernelT requires an arithmetic sample type" );
+public:
+	SumKernelT()
+		: mSum( T() )
+	{
+	}
+
+	inline void begin()
+	{
+		mSum = T();
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new SumKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return (Y)mSum;
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		mSum += reduce::sum( block );
+	}
+protected:
+	T mSum;
+};
+
+template<typename T, typename Y = T>
+class MaxKernelT : public KernelT<T, Y>
+{
+	static_assert( std::is_arithmetic<T>::value, "MaxKernelT requires an arithmetic sample type" );
+public:
+	MaxKernelT()
+		: mEmpty( true ), mMax( T() )
+	{
+	}
+
+	inline void begin()
+	{
+		mEmpty	= true;
+		mMax	= T();
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new MaxKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return (Y)mMax;
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		if ( block.empty() ) {
+			return;
+		}
+		T v		= reduce::maximum( block );
+		mMax	= mEmpty || v > mMax ? v : mMax;
+		mEmpty	= false;
+	}
+protected:
+	bool	mEmpty;
+	T		mMax;
+};
+
+template<typename T, typename Y = T>
+class MinKernelT : public KernelT<T, Y>
+{
+	static_assert( std::is_arithmetic<T>::value, "MinKernelT requires an arithmetic sample type" );
+public:
+	MinKernelT()
+		: mEmpty( true ), mMin( T() )
+	{
+	}
+
+	inline void begin()
+	{
+		mEmpty	= true;
+		mMin	= T();
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new MinKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return (Y)mMin;
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		if ( block.empty() ) {
+			return;
+		}
+		T v		= reduce::minimum( block );
+		mMin	= mEmpty || v < mMin ? v : mMin;
+		mEmpty	= false;
+	}
+protected:
+	bool	mEmpty;
+	T		mMin;
+};
+
+template<typename T, typename Y = T>
+class RmsKernelT : public KernelT<T, Y>
+{
+	static_assert( std::is_arithmetic<T>::value, "RmsKernelT requires an arithmetic sample type" );
+public:
+	RmsKernelT()
+		: mCount( 0 ), mSumSquares( T() )
+	{
+	}
+
+	inline void begin()
+	{
+		mCount		= 0;
+		mSumSquares	= T();
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new RmsKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return mCount > 0 ? (Y)std::sqrt( (double)mSumSquares / (double)mCount ) : Y();
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		mCount		+= block.size();
+		mSumSquares	+= reduce::sumSquares( block );
+	}
+protected:
+	size_t	mCount;
+	T		mSumSquares;
+};
+
+/*
+ * Dot product of the window with a fixed set of weights, oldest sample
+ * first, e.g. an FIR filter tap set. Samples beyond the number of weights
+ * are ignored.
+ */
+template<typename T, typename Y = T>
+class DotKernelT : public KernelT<T, Y>
+{
+	static_assert( std::is_arithmetic<T>::value, "DotKernelT requires an arithmetic sample type" );
+public:
+	DotKernelT( const std::vector<T>& weights = std::vector<T>() )
+		: mOffset( 0 ), mSum( T() ), mWeights( weights )
+	{
+	}
+
+	inline void begin()
+	{
+		mOffset	= 0;
+		mSum	= T();
+	}
+
+	KernelT<T, Y>* clone() const
+	{
+		return new DotKernelT( *this );
+	}
+
+	inline Y end()
+	{
+		return (Y)mSum;
+	}
+
+	inline const std::vector<T>& getWeights() const
+	{
+		return mWeights;
+	}
+
+	inline void update( const SpanT<const T>& block )
+	{
+		if ( mOffset < mWeights.size() ) {
+			size_t count = mWeights.size() - mOffset < block.size() ? mWeights.size() - mOffset : block.size();
+			mSum += reduce::dot( block.data(), mWeights.data() + mOffset, count );
+		}
+		mOffset += block.size();
+	}
+protected:
+	size_t			mOffset;
+	T				mSum;
+	std::vector<T>	mWeights;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+enum WindowFunction
+{
+	WINDOW_BLACKMAN, WINDOW_HAMMING, WINDOW_HANN, WINDOW_RECTANGULAR
+};
+
+/*
+ * A radix-2 FFT plan over the newest getSize() samples of a window. The
+ * bit-reversal table, twiddle factors and window function coefficients are
+ * computed once, and transform() reads the window's segments in place, so
+ * a ring sampler's spectrum needs no copy of getSamples(). A window with
+ * fewer samples than the plan is zero-padded at the oldest end. Results
+ * are the getSize() / 2 + 1 non-negative frequency bins, unnormalized; bin
+ * k is at k * sampleRate / getSize(). An FftT is a process for samplers
+ * whose Y is std::vector<T>, e.g.
+ *
+ *	FftT<float> fft( 1024 );
+ *	spectra.process( ID_SPECTRUM, std::ref( fft ) );
+ *	levels.process( ID_BAND, [ &fft ]( const WindowT<const float>& window )
+ *	{
+ *		return std::abs( fft.transform( window )[ 12 ] );
+ *	} );
+ */
+template<typename T>
+class FftT
+{
+	static_assert( std::is_floating_point<T>::value, "FftT requires a floating point type" );
+public:
+	typedef std::complex<T>	Complex;
+
+	// size is rounded up to a power of two
+	explicit FftT( size_t size, WindowFunction function = WINDOW_HANN )
+		: mFunction( function ), mSize( 1 )
+	{
+		while ( mSize < size ) {
+			mSize <<= 1;
+		}
+		size_t bits = 0;
+		while ( ( (size_t)1 << bits ) < mSize ) {
+			++bits;
+		}
+		mBitReverse.resize( mSize );
+		for ( size_t i = 0; i < mSize; ++i ) {
+			size_t r = 0;
+			for ( size_t b = 0; b < bits; ++b ) {
+				r |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+			}
+			mBitReverse[ i ] = r;
+		}
+		const double tau = 6.283185307179586476925286766559;
+		mTwiddles.resize( mSize / 2 );
+		for ( size_t i = 0; i < mTwiddles.size(); ++i ) {
+			mTwiddles[ i ] = Complex( (T)std::cos( tau * i / mSize ), (T)-std::sin( tau * i / mSize ) );
+		}
+		mCoefficients.resize( mSize );
+		for ( size_t i = 0; i < mSize; ++i ) {
+			double x = tau * i / mSize;
+			double w = 1.0;
+			switch ( mFunction ) {
+			case WINDOW_BLACKMAN:
+				w = 0.42 - 0.5 * std::cos( x ) + 0.08 * std::cos( 2.0 * x );
+				break;
+			case WINDOW_HAMMING:
+				w = 0.54 - 0.46 * std::cos( x );
+				break;
+			case WINDOW_HANN:
+				w = 0.5 - 0.5 * std::cos( x );
+				break;
+			case WINDOW_RECTANGULAR:
+				break;
+			}
+			mCoefficients[ i ] = (T)w;
+		}
+		mBuffer.resize( mSize );
+		mBins.resize( mSize / 2 + 1 );
+		mMagnitudes.resize( mBins.size() );
+	}
+
+	inline const std::vector<Complex>& getBins() const
+	{
+		return mBins;
+	}
+
+	inline WindowFunction getWindowFunction() const
+	{
+		return mFunction;
+	}
+
+	inline size_t getSize() const
+	{
+		return mSize;
+	}
+
+	// Transforms the newest getSize() samples of window and returns the bins
+	template<typename U>
+	inline const std::vector<Complex>& transform( const WindowT<U>& window )
+	{
+		size_t count	= window.size() < mSize ? window.size() : mSize;
+		size_t skip		= window.size() - count;
+		size_t j		= 0;
+		for ( ; j < mSize - count; ++j ) {
+			mBuffer[ mBitReverse[ j ] ] = Complex();
+		}
+		const SpanT<U>* segments[] = { &window.first(), &window.second() };
+		for ( const SpanT<U>* segment : segments ) {
+			size_t first = skip < segment->size() ? skip : segment->size();
+			skip -= first;
+			for ( size_t i = first; i < segment->size(); ++i, ++j ) {
+				mBuffer[ mBitReverse[ j ] ] = Complex( (T)( *segment )[ i ] * mCoefficients[ j ], T() );
+			}
+		}
+
+		Complex* data = mBuffer.data();
+		for ( size_t length = 2; length <= mSize; length <<= 1 ) {
+			size_t half = length / 2;
+			size_t step = mSize / length;
+			for ( size_t i = 0; i < mSize; i += length ) {
+				for ( size_t k = 0; k < half; ++k ) {
+					// Spelled out; std::complex's operator* also handles inf / NaN
+					const Complex& w = mTwiddles[ k * step ];
+					Complex& a = data[ i + k ];
+					Complex& b = data[ i + k + half ];
+					T re = b.real() * w.real() - b.imag() * w.imag();
+					T im = b.real() * w.imag() + b.imag() * w.real();
+					b = Complex( a.real() - re, a.imag() - im );
+					a = Complex( a.real() + re, a.imag() + im );
+				}
+			}
+		}
+		std::copy( mBuffer.begin(), mBuffer.begin() + mBins.size(), mBins.begin() );
+		return mBins;
+	}
+
+	// Transforms window and returns the magnitude of each bin
+	template<typename U>
+	inline const std::vector<T>& magnitudes( const WindowT<U>& window )
+	{
+		transform( window );
+		for ( size_t i = 0; i < mBins.size(); ++i ) {
+			mMagnitudes[ i ] = std::abs( mBins[ i ] );
+		}
+		return mMagnitudes;
+	}
+
+	template<typename U>
+	inline std::vector<T> operator()( const WindowT<U>& window )
+	{
+		return magnitudes( window );
+	}
+protected:
+	std::vector<size_t>		mBitReverse;
+	std::vector<Complex>	mBins;
+	std::vector<Complex>	mBuffer;
+	std::vector<T>			mCoefficients;
+	WindowFunction			mFunction;
+	std::vector<T>			mMagnitudes;
+	size_t					mSize;
+	std::vector<Complex>	mTwiddles;
+};
+
+/*
+ * A sliding DFT over a chosen set of bins of a size-point transform, kept
+ * as an accumulator so each sample pushed into the sampler costs O(bins)
+ * rather than a full FFT. Bin k is at k * sampleRate / size; use the
+ * sampler's window size as size for the usual DFT bins. getBin() returns
+ * bin i referenced to the oldest sample in the window, as a DFT of the
+ * window would. getValue() is the root of the summed power of every
+ * tracked bin, which for a single bin is its magnitude. The window is
+ * rectangular. Sums are kept in double, and the error that accumulates
+ * over very long runs is cleared whenever the sampler resyncs its
+ * accumulators (e.g. resetAccumulators()).
+ */
+template<typename T, typename Y = T>
+class SlidingDftT : public AccumulatorT<T, Y>
+{
+public:
+	typedef std::complex<double>	Complex;
+
+	SlidingDftT( size_t size, const std::vector<size_t>& bins )
+		: mBins( bins ), mHead( 0 ), mSize( size < 1 ? 1 : size ), mTail( 0 )
+	{
+		init();
+	}
+
+	SlidingDftT( size_t size, size_t bin )
+		: mBins( 1, bin ), mHead( 0 ), mSize( size < 1 ? 1 : size ), mTail( 0 )
+	{
+		init();
+	}
+
+	AccumulatorT<T, Y>* clone() const
+	{
+		return new SlidingDftT( *this );
+	}
+
+	inline void clear()
+	{
+		std::fill( mSums.begin(), mSums.end(), Complex() );
+		mHead = 0;
+		mTail = 0;
+	}
+
+	// Tracked bin i, as a DFT of the current window would compute it
+	inline Complex getBin( size_t i ) const
+	{
+		size_t k = mBins[ i ] % mSize;
+		return mSums[ i ] * mRoots[ ( k * mHead ) % mSize ];
+	}
+
+	// The bin number that tracked bin i follows
+	inline size_t getBinIndex( size_t i ) const
+	{
+		return mBins[ i ];
+	}
+
+	inline size_t getNumBins() const
+	{
+		return mBins.size();
+	}
+
+	inline Y getValue() const
+	{
+		double power = 0.0;
+		for ( const Complex& sum : mSums ) {
+			power += std::norm( sum );
+		}
+		return (Y)std::sqrt( power );
+	}
+
+	inline void pop( const T& v )
+	{
+		add( -(double)v, mHead );
+		mHead = mHead + 1 == mSize ? 0 : mHead + 1;
+	}
+
+	inline void push( const T& v )
+	{
+		add( (double)v, mTail );
+		mTail = mTail + 1 == mSize ? 0 : mTail + 1;
+	}
+protected:
+	std::vector<size_t>		mBins;
+	size_t					mHead;
+	std::vector<Complex>	mRoots;
+	size_t					mSize;
+	std::vector<Complex>	mSums;
+	size_t					mTail;
+
+	// Adds x at time t (mod size) to every tracked bin: X_k += x * e^(-2 pi i k t / size)
+	inline void add( double x, size_t t )
+	{
+		for ( size_t i = 0; i < mBins.size(); ++i ) {
+			size_t k = mBins[ i ] % mSize;
+			mSums[ i ] += x * std::conj( mRoots[ ( k * t ) % mSize ] );
+		}
+	}
+
+	// mRoots[ n ] = e^(2 pi i n / size)
+	inline void init()
+	{
+		const double tau = 6.283185307179586476925286766559;
+		mRoots.resize( mSize );
+		for ( size_t n = 0; n < mSize; ++n ) {
+			mRoots[ n ] = Complex( std::cos( tau * n / mSize ), std::sin( tau * n / mSize ) );
+		}
+		mSums.assign( mBins.size(), Complex() );
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * An executor takes a task and runs it, now or later, on any thread.
+ * SamplerT::setExecutor() accepts one to run independent processes
+ * concurrently; wrap your own job system in it or use ThreadPool.
+ */
+typedef std::function<void( const std::function<void()>& )> Executor;
+
+/*
+ * A fixed set of worker threads draining one shared FIFO queue. Enough to
+ * spread a handful of expensive processes across cores.
+ */
+class ThreadPool
+{
+public:
+	ThreadPool( size_t numThreads = 0 )
+		: mDone( false )
+	{
+		if ( numThreads == 0 ) {
+			numThreads = std::thread::hardware_concurrency();
+		}
+		if ( numThreads == 0 ) {
+			numThreads = 1;
+		}
+		for ( size_t i = 0; i < numThreads; ++i ) {
+			mThreads.push_back( std::thread( &ThreadPool::run, this ) );
+		}
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mDone = true;
+		}
+		mCondition.notify_all();
+		for ( std::thread& thread : mThreads ) {
+			thread.join();
+		}
+	}
+
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+
+	// The pool must outlive the executor
+	inline Executor getExecutor()
+	{
+		return [ this ]( const std::function<void()>& task )
+		{
+			submit( task );
+		};
+	}
+
+	inline size_t getNumThreads() const
+	{
+		return mThreads.size();
+	}
+
+	inline void submit( const std::function<void()>& task )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mTasks.push_back( task );
+		}
+		mCondition.notify_one();
+	}
+protected:
+	std::condition_variable				mCondition;
+	bool								mDone;
+	std::mutex							mMutex;
+	std::deque<std::function<void()> >	mTasks;
+	std::vector<std::thread>			mThreads;
+
+	inline void run()
+	{
+		for ( ;; ) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock( mMutex );
+				mCondition.wait( lock, [ this ]()
+				{
+					return mDone || !mTasks.empty();
+				} );
+				if ( mTasks.empty() ) {
+					return;
+				}
+				task = std::move( mTasks.front() );
+				mTasks.pop_front();
+			}
+			task();
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * An immutable view of a sampler's window, tagged with the generation it
+ * was taken at. It keeps the samples it shows alive: storage that can
+ * share its buffer (RingStorageT) is pinned rather than copied, and any
+ * other storage is copied once. Copies of a SnapshotT share the same
+ * samples, so a snapshot can be handed to any number of threads and kept
+ * for as long as needed. Run processes on it with
+ * SamplerT::runProcess( index, snapshot.getWindow() ).
+ */
+template<typename T, typename A = std::allocator<T> >
+class SnapshotT
+{
+public:
+	typedef std::vector<T, A>							container_type;	// Holds a copy of unshareable storage
+	typedef typename WindowT<const T>::iterator			const_iterator;
+
+	SnapshotT()
+		: mGeneration( 0 ), mNumPadding( 0 )
+	{
+	}
+
+	SnapshotT( const std::shared_ptr<const void>& owner, const WindowT<const T>& window, uint64_t generation, size_t numPadding )
+		: mGeneration( generation ), mNumPadding( numPadding ), mOwner( owner ), mWindow( window )
+	{
+	}
+
+	inline const T& operator[]( size_t index ) const
+	{
+		return mWindow[ index ];
+	}
+
+	inline const_iterator begin() const
+	{
+		return mWindow.begin();
+	}
+
+	inline const_iterator end() const
+	{
+		return mWindow.end();
+	}
+
+	inline bool empty() const
+	{
+		return mWindow.empty();
+	}
+
+	// The sampler's getGeneration() when this was taken; zero if never taken
+	inline uint64_t getGeneration() const
+	{
+		return mGeneration;
+	}
+
+	inline size_t getNumValidSamples() const
+	{
+		return size() - mNumPadding;
+	}
+
+	inline const WindowT<const T>& getWindow() const
+	{
+		return mWindow;
+	}
+
+	inline size_t size() const
+	{
+		return mWindow.size();
+	}
+protected:
+	uint64_t					mGeneration;
+	size_t						mNumPadding;
+	std::shared_ptr<const void>	mOwner;
+	WindowT<const T>			mWindow;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ExportMode
+{
+	EXPORT_DELTA, EXPORT_FULL
+};
+
+/*
+ * The fixed-size header that starts every exported frame. The count
+ * samples follow it as raw bytes in the sender's native layout, so both
+ * ends must agree on T and byte order. A full frame carries the valid
+ * samples of the window; a delta frame carries only the samples pushed
+ * since baseSequence and applies on top of the frame that ended there.
+ */
+struct ExportHeader
+{
+	static const uint32_t	kMagic		= 0x57504d53;	// "SMPW"
+	static const uint8_t	kVersion	= 2;
+
+	uint32_t	magic;
+	uint8_t		version;
+	uint8_t		mode;			// ExportMode
+	uint16_t	sampleSize;
+	uint64_t	count;			// Samples following the header
+	uint64_t	numSamples;		// The sender's getNumSamples()
+	uint64_t	generation;		// The sender's getGeneration()
+	uint64_t	baseSequence;	// Samples pushed before this frame's first one
+	uint64_t	sequence;		// Samples pushed up to and including its last one
+};
+
+/*
+ * Where a consumer's last export left off. Start from a default cursor;
+ * SamplerT::exportWindow() advances it. A cursor belongs to one sampler.
+ */
+struct ExportCursor
+{
+	ExportCursor()
+		: generation( 0 ), sequence( 0 )
+	{
+	}
+
+	uint64_t generation;
+	uint64_t sequence;
+};
+
+/*
+ * An exported frame as up to three buffers: the header and the one or
+ * two storage segments holding its samples. Nothing is copied, so hand the
+ * buffers straight to writev(), sendmsg() or WSASend(), or flatten them
+ * with copyTo(). The segments point into the sampler and are only valid
+ * until it changes.
+ */
+template<typename T>
+class WindowExportT
+{
+public:
+	WindowExportT( const ExportHeader& header, const WindowT<const T>& samples )
+		: mHeader( header ), mSamples( samples )
+	{
+	}
+
+	// Copies the frame into data, which must hold getByteSize() bytes
+	inline void copyTo( void* data ) const
+	{
+		unsigned char* out = static_cast<unsigned char*>( data );
+		for ( size_t i = 0; i < getNumBuffers(); ++i ) {
+			std::memcpy( out, getData( i ), getSize( i ) );
+			out += getSize( i );
+		}
+	}
+
+	inline const ExportHeader& getHeader() const
+	{
+		return mHeader;
+	}
+
+	inline size_t getByteSize() const
+	{
+		return sizeof( ExportHeader ) + mSamples.size() * sizeof( T );
+	}
+
+	inline const void* getData( size_t index ) const
+	{
+		return index == 0 ? static_cast<const void*>( &mHeader ) :
+			index == 1 ? static_cast<const void*>( mSamples.first().data() ) : static_cast<const void*>( mSamples.second().data() );
+	}
+
+	inline size_t getNumBuffers() const
+	{
+		return 1 + ( mSamples.first().empty() ? 0 : 1 ) + ( mSamples.second().empty() ? 0 : 1 );
+	}
+
+	inline size_t getSize( size_t index ) const
+	{
+		return index == 0 ? sizeof( ExportHeader ) :
+			index == 1 ? mSamples.first().size() * sizeof( T ) : mSamples.second().size() * sizeof( T );
+	}
+
+	inline const WindowT<const T>& getSamples() const
+	{
+		return mSamples;
+	}
+
+	inline bool isDelta() const
+	{
+		return mHeader.mode == EXPORT_DELTA;
+	}
+
+#if defined( SAMPLING_POSIX )
+	// Writes the whole frame to fd with writev(), resuming after short writes
+	inline bool writeTo( int fd ) const
+	{
+		struct iovec buffers[ 3 ];
+		size_t count = getNumBuffers();
+		for ( size_t i = 0; i < count; ++i ) {
+			buffers[ i ].iov_base	= const_cast<void*>( getData( i ) );
+			buffers[ i ].iov_len	= getSize( i );
+		}
+		struct iovec* buffer = buffers;
+		while ( count > 0 ) {
+			ssize_t written = ::writev( fd, buffer, (int)count );
+			if ( written < 0 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				return false;
+			}
+			size_t remaining = (size_t)written;
+			while ( count > 0 && remaining >= buffer->iov_len ) {
+				remaining -= buffer->iov_len;
+				++buffer;
+				--count;
+			}
+			if ( count > 0 ) {
+				buffer->iov_base	= static_cast<char*>( buffer->iov_base ) + remaining;
+				buffer->iov_len		-= remaining;
+			}
+		}
+		return true;
+	}
+#endif
+protected:
+	ExportHeader		mHeader;
+	WindowT<const T>	mSamples;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// What an instrumented sampler records about one process ID
+struct ProcessStats
+{
+	uint64_t	cacheHits;			// runProcess() calls answered from the cache
+	uint64_t	calls;				// Times the process actually ran
+	uint64_t	invalidGeneration;	// getGeneration() of the change that last made it run again; zero before that
+	uint64_t	maxNanoseconds;
+	uint64_t	runGeneration;		// getGeneration() when it last ran on the sampler's own window
+	uint64_t	totalNanoseconds;
+};
+
+struct SamplerStats
+{
+	uint64_t					firstIngest;		// steady_clock time, in nanoseconds
+	uint64_t					lastIngest;
+	uint64_t					numIngested;		// Samples given to pushBack() and append()
+	std::vector<ProcessStats>	processes;			// By process ID
+
+	// Samples per second between the first and the latest ingest
+	inline double getIngestRate() const
+	{
+		return lastIngest > firstIngest ? numIngested * 1.0e9 / ( lastIngest - firstIngest ) : 0.0;
+	}
+
+	// All zero for an ID that never ran
+	inline ProcessStats getProcess( size_t index ) const
+	{
+		return index < processes.size() ? processes[ index ] : ProcessStats();
+	}
+};
+
+/*
+ * Instrumentation policies are the fourth SamplerT parameter. The default,
+ * NullInstrumentation, has empty hooks and a clock that always reads zero,
+ * so an uninstrumented sampler compiles to the same code as before and
+ * getStats() returns empty stats. Instrumentation times every process run
+ * through runProcess(), tryRunProcess() and the batch runs (fused kernels
+ * share their pass evenly) and counts ingested samples, e.g.
+ *
+ *	SamplerT<float, float, RingStorageT<float>, Instrumentation> sampler;
+ *	sampler.getStats().getProcess( ID_SPECTRUM ).maxNanoseconds;
+ *
+ * runProcessAsync() is not recorded, since it finishes on another thread.
+ */
+struct NullInstrumentation
+{
+	static const bool kEnabled = false;
+
+	static inline uint64_t now()
+	{
+		return 0;
+	}
+
+	inline const SamplerStats& getStats() const
+	{
+		static const SamplerStats stats = SamplerStats();
+		return stats;
+	}
+
+	inline void onCacheHit( size_t )
+	{
+	}
+
+	inline void onIngest( size_t )
+	{
+	}
+
+	inline void onProcess( size_t, uint64_t, uint64_t )
+	{
+	}
+
+	inline void resetStats()
+	{
+	}
+};
+
+class Instrumentation
+{
+public:
+	static const bool kEnabled = true;
+
+	Instrumentation()
+		: mStats( SamplerStats() )
+	{
+	}
+
+	static inline uint64_t now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
+
+	inline const SamplerStats& getStats() const
+	{
+		return mStats;
+	}
+
+	inline void onCacheHit( size_t index )
+	{
+		++get( index ).cacheHits;
+	}
+
+	inline void onIngest( size_t count )
+	{
+		uint64_t time = now();
+		if ( mStats.numIngested == 0 ) {
+			mStats.firstIngest = time;
+		}
+		mStats.lastIngest	= time;
+		mStats.numIngested	+= count;
+	}
+
+	/*
+	 * generation is zero for a window other than the sampler's own. A run on
+	 * its own window is a miss, so its last result went stale with the first
+	 * change after it ran, or now if the process itself was replaced.
+	 */
+	inline void onProcess( size_t index, uint64_t nanoseconds, uint64_t generation )
+	{
+		ProcessStats& stats = get( index );
+		++stats.calls;
+		stats.totalNanoseconds	+= nanoseconds;
+		stats.maxNanoseconds	= nanoseconds > stats.maxNanoseconds ? nanoseconds : stats.maxNanoseconds;
+		if ( generation != 0 ) {
+			if ( stats.runGeneration != 0 ) {
+				stats.invalidGeneration = stats.runGeneration < generation ? stats.runGeneration + 1 : generation;
+			}
+			stats.runGeneration = generation;
+		}
+	}
+
+	inline void resetStats()
+	{
+		mStats = SamplerStats();
+	}
+protected:
+	SamplerStats	mStats;
+
+	inline ProcessStats& get( size_t index )
+	{
+		if ( index >= mStats.processes.size() ) {
+			mStats.processes.resize( index + 1, ProcessStats() );
+		}
+		return mStats.processes[ index ];
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// The window size a sampler starts with when none is given
+template<typename S>
+struct DefaultNumSamplesT
+{
+	static const size_t value = 2;
+};
+
+template<typename T, size_t N>
+struct DefaultNumSamplesT<FixedRingStorageT<T, N> >
+{
+	static const size_t value = N;
+};
+
+template<typename T, typename Y, typename S = VectorStorageT<T>, typename I = NullInstrumentation>
+class SamplerT
+{
+public:
+	typedef typename S::allocator_type												allocator_type;
+	typedef WindowT<const T>														Window;
+	typedef InplaceFunctionT<Y( const Window& )>									Process;
+	typedef ProcessTableT<Process, RebindAllocT<allocator_type, Process> >			ProcessMap;
+	typedef SnapshotT<T, RebindAllocT<allocator_type, T> >							Snapshot;
+	typedef WindowExportT<T>														WindowExport;
+protected:
+	typedef std::pair<size_t, std::unique_ptr<AccumulatorT<T, Y> > >	AccumulatorEntry;
+	typedef std::pair<size_t, std::unique_ptr<KernelT<T, Y> > >			KernelEntry;
+
+	// A process computed from the results of the processes in mInputs
+	struct Node
+	{
+		InplaceFunctionT<Y( const Window&, const Y* )>	mFunc;
+		std::vector<size_t>								mInputs;
+	};
+	typedef ProcessTableT<Node, RebindAllocT<allocator_type, Node> >	Graph;
+
+	// A process of any result type, constructing its result at the pointer
+	struct TypedProcess
+	{
+		InplaceFunctionT<void( const Window&, void* )>	mFunc;
+		const void*										mType;
+	};
+	typedef ProcessTableT<TypedProcess, RebindAllocT<allocator_type, TypedProcess> >	TypedProcessMap;
+
+	/*
+	 * Holds a typed process's callable in a TypedProcess. A move-only
+	 * callable is moved to the heap and shared, since the table entry, and
+	 * the sampler with it, must stay copyable.
+	 */
+	template<typename R, typename F, bool Copyable = std::is_copy_constructible<F>::value>
+	struct TypedHolderT
+	{
+		template<typename U>
+		explicit TypedHolderT( U&& func )
+			: mFunc( std::forward<U>( func ) )
+		{
+		}
+
+		inline void operator()( const Window& window, void* result )
+		{
+			new ( result ) R( invokeTyped( mFunc, window, 0 ) );
+		}
+
+		F	mFunc;
+	};
+
+	template<typename R, typename F>
+	struct TypedHolderT<R, F, false>
+	{
+		template<typename U>
+		explicit TypedHolderT( U&& func )
+			: mFunc( std::make_shared<F>( std::forward<U>( func ) ) )
+		{
+		}
+
+		inline void operator()( const Window& window, void* result )
+		{
+			new ( result ) R( invokeTyped( *mFunc, window, 0 ) );
+		}
+
+		std::shared_ptr<F>	mFunc;
+	};
+
+	struct TriggerEntry
+	{
+		size_t													mId;
+		size_t													mIndex;
+		bool													mPrimed;	// mPrevious holds a value
+		Y														mPrevious;
+		InplaceFunctionT<bool( const Y&, const Y& )>			mTest;
+		InplaceFunctionT<void( const TriggerEventT<Y>& )>		mCallback;
+	};
+
+	// snapshot() for storage that can share its buffer
+	template<typename U>
+	inline auto makeSnapshot( const U& samples, int ) -> decltype( samples.share(), Snapshot() )
+	{
+		return Snapshot( samples.share(), samples.getWindow(), mGeneration, mNumPadding );
+	}
+
+	// and for the rest, a copy cached until the samples change
+	template<typename U>
+	inline Snapshot makeSnapshot( const U& samples, long )
+	{
+		if ( mSnapshot.getGeneration() != mGeneration ) {
+			typedef typename Snapshot::container_type Container;
+			WindowT<const T> window = samples.getWindow();
+			std::shared_ptr<Container> copy = std::allocate_shared<Container>( RebindAllocT<allocator_type, Container>( getAllocator() ),
+				Container( getAllocator() ) );
+			copy->reserve( window.size() );
+			copy->insert( copy->end(), window.first().begin(), window.first().end() );
+			copy->insert( copy->end(), window.second().begin(), window.second().end() );
+			mSnapshot = Snapshot( copy, WindowT<const T>( SpanT<const T>( copy->data(), copy->size() ) ), mGeneration, mNumPadding );
+		}
+		return mSnapshot;
+	}
+
+	template<typename F>
+	static inline auto invokeTyped( F& func, const Window& window, int ) -> decltype( func( window ) )
+	{
+		return func( window );
+	}
+
+	template<typename F>
+	static inline auto invokeTyped( F& func, const Window&, long ) -> decltype( func() )
+	{
+		return func();
+	}
+
+	size_t									mNumPadding;
+	size_t									mNumSamples;
+	bool									mPadded;
+	ProcessMap								mProcessMap;
+	S										mSamples;
+
+	std::vector<AccumulatorEntry, RebindAllocT<allocator_type, AccumulatorEntry> >	mAccumulators;
+	std::vector<KernelEntry, RebindAllocT<allocator_type, KernelEntry> >			mKernels;
+	std::vector<KernelT<T, Y>*>				mBatchKernels;
+	std::vector<size_t>						mBatchIndices;
+	std::vector<size_t>						mBatchFirsts;		// By ID, where in the batch it first appears
+	std::vector<size_t>						mBatchMisses;
+	std::vector<const Process*>			mBatchProcesses;
+	std::vector<size_t>						mBatchRepeats;
+	std::vector<size_t>						mBatchSerial;
+	Executor								mExecutor;
+
+	// Results by process ID, valid while their generation is mGeneration
+	typedef std::pair<uint64_t, Y>			CacheEntry;
+	bool									mCaching;
+	std::vector<CacheEntry, RebindAllocT<allocator_type, CacheEntry> >	mCache;
+	uint64_t								mGeneration;
+	uint64_t								mEditGeneration;	// mGeneration after the last change that was not a push
+	uint64_t								mNumPushed;
+	mutable I								mInstrumentation;
+	Snapshot								mSnapshot;
+	std::vector<uint64_t>					mBatchTimes;
+
+	// Results of graph nodes and their inputs on this sampler's window,
+	// valid while their generation is mGeneration. Without caching they
+	// only last one evaluation; see beginEvaluation()
+	Graph									mGraph;
+	mutable std::vector<CacheEntry, RebindAllocT<allocator_type, CacheEntry> >	mResults;
+	TypedProcessMap							mTypedProcesses;
+
+	std::vector<TriggerEntry, RebindAllocT<allocator_type, TriggerEntry> >	mTriggers;
+	size_t									mNextTrigger;
+	size_t									mTriggerInterval;
+	size_t									mTriggerPending;	// Samples ingested since triggers last ran
+
+	inline const Y* findCached( size_t index ) const
+	{
+		if ( mCaching && index < mCache.size() && mCache[ index ].first == mGeneration ) {
+			return &mCache[ index ].second;
+		}
+		return nullptr;
+	}
+
+	inline void storeCached( size_t index, const Y& value )
+	{
+		if ( !mCaching ) {
+			return;
+		}
+		if ( index >= mCache.size() ) {
+			mCache.resize( index + 1, CacheEntry( 0, Y() ) );
+		}
+		mCache[ index ] = CacheEntry( mGeneration, value );
+	}
+
+	inline void dropCached( size_t index )
+	{
+		if ( index < mCache.size() ) {
+			mCache[ index ].first = 0;
+		}
+	}
+
+	inline void fit()
+	{
+		trim( 0 );
+		if ( mPadded && mSamples.size() < mNumSamples ) {
+			size_t count = mNumSamples - mSamples.size();
+			mSamples.padFront( count );
+			mNumPadding += count;
+			resetAccumulators();
+		}
+	}
+
+	// Removes the oldest count samples, telling accumulators about each one
+	inline void evict( size_t count )
+	{
+		for ( AccumulatorEntry& entry : mAccumulators ) {
+			if ( count == mSamples.size() ) {
+				entry.second->clear();
+				continue;
+			}
+			for ( size_t i = 0; i < count; ++i ) {
+				entry.second->pop( mSamples[ i ] );
+			}
+		}
+		mSamples.eraseFront( count );
+		mNumPadding -= count < mNumPadding ? count : mNumPadding;
+	}
+
+	inline void pushAccumulators( const T& v )
+	{
+		for ( AccumulatorEntry& entry : mAccumulators ) {
+			entry.second->push( v );
+		}
+	}
+
+	// Binds the accumulator's process to this sampler's instance
+	inline void setAccumulatorProcess( size_t index, const AccumulatorT<T, Y>* accumulator )
+	{
+		setProcess( index, [ accumulator ]( const Window& ) -> Y
+		{
+			return accumulator->getValue();
+		} );
+	}
+
+	// Binds the kernel's process to this sampler's instance
+	inline void setKernelProcess( size_t index, KernelT<T, Y>* kernel )
+	{
+		setProcess( index, [ kernel ]( const Window& window ) -> Y
+		{
+			kernel->begin();
+			kernel->update( window.first() );
+			if ( !window.second().empty() ) {
+				kernel->update( window.second() );
+			}
+			return kernel->end();
+		} );
+	}
+
+	// Binds the node's process to this sampler's graph
+	inline void bindNode( size_t index )
+	{
+		mProcessMap[ index ] = Process( [ this, index ]( const Window& window ) -> Y
+		{
+			Y value = Y();
+			size_t failed;
+			beginEvaluation();
+			ProcessError error = evaluate( index, window, value, failed );
+			if ( error == PROCESS_NOT_FOUND ) {
+				SAMPLING_THROW( ExcProcNotFound( failed ) );
+			}
+			if ( error == PROCESS_UNDEFINED ) {
+				SAMPLING_THROW( ExcProcUndefined( failed ) );
+			}
+			return value;
+		} );
+	}
+
+	inline void bindNodes()
+	{
+		for ( const typename Graph::Entry& entry : mGraph ) {
+			bindNode( entry.first );
+		}
+	}
+
+	// Whether index is target or reaches it through graph inputs
+	inline bool dependsOn( size_t index, size_t target ) const
+	{
+		if ( index == target ) {
+			return true;
+		}
+		const Node* node = mGraph.get( index );
+		if ( node != nullptr ) {
+			for ( size_t input : node->mInputs ) {
+				if ( dependsOn( input, target ) ) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Forgets graph results, and cached ones that may have read them
+	inline void dropResults()
+	{
+		mResults.clear();
+		for ( const typename Graph::Entry& entry : mGraph ) {
+			dropCached( entry.first );
+		}
+	}
+
+	// Starts a graph evaluation, which without caching must not see results of earlier ones
+	inline void beginEvaluation() const
+	{
+		if ( !mCaching ) {
+			mResults.clear();
+		}
+	}
+
+	inline const Y* findResult( size_t index ) const
+	{
+		if ( index < mResults.size() && mResults[ index ].first == mGeneration ) {
+			return &mResults[ index ].second;
+		}
+		return nullptr;
+	}
+
+	inline void storeResult( size_t index, const Y& value ) const
+	{
+		if ( index >= mResults.size() ) {
+			mResults.resize( index + 1, CacheEntry( 0, Y() ) );
+		}
+		mResults[ index ] = CacheEntry( mGeneration, value );
+	}
+
+	// Results are only kept for the samples themselves, not other windows
+	inline bool isOwnWindow( const Window& window ) const
+	{
+		Window own = mSamples.getWindow();
+		return window.first().data() == own.first().data() && window.second().data() == own.second().data() &&
+			window.size() == own.size();
+	}
+
+	/*
+	 * Runs node index on window, evaluating its inputs first. Inputs are
+	 * looked up without throwing: if one has been erased or is undefined,
+	 * this returns why and sets failed to its ID, leaving value alone.
+	 */
+	inline ProcessError evaluate( size_t index, const Window& window, Y& value, size_t& failed ) const
+	{
+		bool own = isOwnWindow( window );
+		const Y* result = own ? findResult( index ) : nullptr;
+		if ( result != nullptr ) {
+			value = *result;
+			return PROCESS_NONE;
+		}
+		ProcessError error = runNode( *mGraph.get( index ), window, own, value, failed );
+		if ( error == PROCESS_NONE && own ) {
+			storeResult( index, value );
+		}
+		return error;
+	}
+
+	/*
+	 * A node's input results, constructed one by one as they are computed
+	 * rather than default-constructed up front. The first kNumLocal live in
+	 * place; a node with more inputs puts them all on the heap.
+	 */
+	class NodeInputs
+	{
+	public:
+		static const size_t kNumLocal = 8;
+
+		explicit NodeInputs( size_t count )
+			: mData( count > kNumLocal ? static_cast<Y*>( ::operator new( count * sizeof( Y ) ) ) : reinterpret_cast<Y*>( &mLocal ) ),
+			mSize( 0 )
+		{
+		}
+
+		~NodeInputs()
+		{
+			for ( size_t i = 0; i < mSize; ++i ) {
+				mData[ i ].~Y();
+			}
+			if ( mData != reinterpret_cast<Y*>( &mLocal ) ) {
+				::operator delete( mData );
+			}
+		}
+
+		NodeInputs( const NodeInputs& ) = delete;
+		NodeInputs& operator=( const NodeInputs& ) = delete;
+
+		inline const Y* data() const
+		{
+			return mData;
+		}
+
+		template<typename V>
+		inline void pushBack( V&& value )
+		{
+			new ( mData + mSize ) Y( std::forward<V>( value ) );
+			++mSize;
+		}
+	protected:
+		typename std::aligned_storage<sizeof( Y ) * kNumLocal, alignof( Y )>::type	mLocal;
+		Y*																		mData;
+		size_t																	mSize;
+	};
+
+	// Calls the node with its inputs, reusing their results on own samples
+	inline ProcessError runNode( const Node& node, const Window& window, bool own, Y& value, size_t& failed ) const
+	{
+		const Y* result;
+		ProcessError error;
+		NodeInputs inputs( node.mInputs.size() );
+		for ( size_t i = 0; i < node.mInputs.size(); ++i ) {
+			size_t input	= node.mInputs[ i ];
+			result			= own ? findResult( input ) : nullptr;
+			if ( result != nullptr ) {
+				inputs.pushBack( *result );
+			} else if ( mGraph.count( input ) > 0 ) {
+				Y output = Y();
+				error = evaluate( input, window, output, failed );
+				if ( error != PROCESS_NONE ) {
+					return error;
+				}
+				inputs.pushBack( std::move( output ) );
+			} else {
+				const Process* func = findProcess( input, error );
+				if ( func == nullptr ) {
+					failed = input;
+					return error;
+				}
+				inputs.pushBack( ( *func )( window ) );
+				if ( own ) {
+					storeResult( input, inputs.data()[ i ] );
+				}
+			}
+		}
+		value = node.mFunc( window, inputs.data() );
+		return PROCESS_NONE;
+	}
+
+	// Runs index on window without throwing over a missing or undefined process
+	inline ProcessError runChecked( size_t index, const Window& window, Y& result ) const
+	{
+		ProcessError error;
+		if ( mGraph.count( index ) > 0 ) {
+			size_t failed;
+			Y value = Y();
+			beginEvaluation();
+			error = evaluate( index, window, value, failed );
+			if ( error == PROCESS_NONE ) {
+				result = value;
+			}
+			return error;
+		}
+		const Process* func = findProcess( index, error );
+		if ( func != nullptr ) {
+			result = ( *func )( window );
+		}
+		return error;
+	}
+
+	// Collects what index needs evaluated, inputs before the nodes reading
+	// them, and returns its depth: one more than its deepest input's
+	inline size_t collectNode( size_t index, std::vector<size_t>& order, std::vector<size_t>& depths ) const
+	{
+		if ( index < depths.size() && depths[ index ] > 0 ) {
+			return depths[ index ];
+		}
+		if ( findResult( index ) != nullptr ) {
+			return 0;
+		}
+		size_t depth = 1;
+		const Node* node = mGraph.get( index );
+		if ( node != nullptr ) {
+			for ( size_t input : node->mInputs ) {
+				size_t inputDepth = collectNode( input, order, depths );
+				depth = inputDepth + 1 > depth ? inputDepth + 1 : depth;
+			}
+		} else {
+			resolveProcess( index );
+		}
+		if ( index >= depths.size() ) {
+			depths.resize( index + 1, 0 );
+		}
+		depths[ index ] = depth;
+		order.push_back( index );
+		return depth;
+	}
+
+	/*
+	 * Evaluates the graph nodes in indices, and everything they read, a
+	 * level at a time: all processes of a level only read results of
+	 * earlier ones, so each level runs concurrently on the executor.
+	 */
+	inline void evaluateGraph( const size_t* indices, size_t count )
+	{
+		std::vector<size_t> order;
+		std::vector<size_t> depths;
+		beginEvaluation();
+		for ( size_t i = 0; i < count; ++i ) {
+			if ( mGraph.count( indices[ i ] ) > 0 ) {
+				collectNode( indices[ i ], order, depths );
+			}
+		}
+		const Window window = mSamples.getWindow();
+		std::vector<size_t> level;
+		std::vector<Y> values;
+		for ( size_t depth = 1; !order.empty(); ++depth ) {
+			level.clear();
+			for ( size_t i = 0; i < order.size(); ) {
+				if ( depths[ order[ i ] ] == depth ) {
+					level.push_back( order[ i ] );
+					order.erase( order.begin() + i );
+				} else {
+					++i;
+				}
+			}
+			values.assign( level.size(), Y() );
+			runParallel( level.size(), [ & ]( size_t i )
+			{
+				// Inputs are all results of earlier levels, so this only reads
+				const Node* node = mGraph.get( level[ i ] );
+				if ( node == nullptr ) {
+					values[ i ] = resolveProcess( level[ i ] )( window );
+					return;
+				}
+				size_t failed;
+				ProcessError error = runNode( *node, window, true, values[ i ], failed );
+				if ( error == PROCESS_NOT_FOUND ) {
+					SAMPLING_THROW( ExcProcNotFound( failed ) );
+				}
+				if ( error == PROCESS_UNDEFINED ) {
+					SAMPLING_THROW( ExcProcUndefined( failed ) );
+				}
+			} );
+			for ( size_t i = 0; i < level.size(); ++i ) {
+				storeResult( level[ i ], values[ i ] );
+			}
+		}
+	}
+
+	/*
+	 * Calls task( i ) for every i below count, concurrently on the
+	 * executor with the calling thread taking i = 0, and returns once all
+	 * are done. The first exception a task throws is rethrown here.
+	 */
+	template<typename F>
+	inline void runParallel( size_t count, const F& task )
+	{
+		if ( mExecutor == nullptr || count < 2 ) {
+			for ( size_t i = 0; i < count; ++i ) {
+				task( i );
+			}
+			return;
+		}
+		std::condition_variable	done;
+		std::exception_ptr		error;
+		std::mutex				mutex;
+		size_t					remaining = count;
+		auto run = [ & ]( size_t i )
+		{
+#if defined( SAMPLING_EXCEPTIONS )
+			try {
+				task( i );
+			} catch ( ... ) {
+				std::lock_guard<std::mutex> lock( mutex );
+				if ( error == nullptr ) {
+					error = std::current_exception();
+				}
+			}
+#else
+			task( i );
+#endif
+			std::lock_guard<std::mutex> lock( mutex );
+			if ( --remaining == 0 ) {
+				done.notify_all();
+			}
+		};
+		for ( size_t i = 1; i < count; ++i ) {
+			mExecutor( std::bind( run, i ) );
+		}
+		run( 0 );
+
+		std::unique_lock<std::mutex> lock( mutex );
+		done.wait( lock, [ & ]()
+		{
+			return remaining == 0;
+		} );
+#if defined( SAMPLING_EXCEPTIONS )
+		if ( error != nullptr ) {
+			std::rethrow_exception( error );
+		}
+#endif
+	}
+
+	// Keeps the window size between one and what the storage can hold
+	inline void clampNumSamples()
+	{
+		if ( mNumSamples < 1 ) {
+			mNumSamples = 1;
+		} else if ( mNumSamples > mSamples.maxSize() ) {
+			mNumSamples = mSamples.maxSize();
+		}
+	}
+
+	// Runs the triggers once count more samples bring them due
+	inline void runTriggers( size_t count )
+	{
+		mTriggerPending += count;
+		if ( mTriggerPending < mTriggerInterval ) {
+			return;
+		}
+		mTriggerPending = 0;
+		for ( size_t i = 0; i < mTriggers.size(); ++i ) {
+			TriggerEntry& entry = mTriggers[ i ];
+			Y value = Y();
+			if ( tryRunProcess( entry.mIndex, value ) != PROCESS_NONE ) {
+				continue;
+			}
+			if ( entry.mPrimed && entry.mTest( entry.mPrevious, value ) ) {
+				TriggerEventT<Y> event = { entry.mId, entry.mIndex, entry.mPrevious, value };
+				entry.mCallback( event );
+			}
+			entry.mPrevious	= value;
+			entry.mPrimed	= true;
+		}
+	}
+
+	// Bumps the generation for a change that a delta export cannot describe
+	inline void markEdited()
+	{
+		mEditGeneration = ++mGeneration;
+	}
+
+	// Whether v is one of the samples in the window
+	inline bool isOwnSample( const T& v ) const
+	{
+		WindowT<const T> window = mSamples.getWindow();
+		std::less<const T*> before;
+		return ( !before( &v, window.first().begin() ) && before( &v, window.first().end() ) ) ||
+			( !before( &v, window.second().begin() ) && before( &v, window.second().end() ) );
+	}
+
+	template<typename V>
+	inline void pushSample( V&& v )
+	{
+		mInstrumentation.onIngest( 1 );
+		++mNumPushed;
+		trim( 1 );
+		mSamples.pushBack( std::forward<V>( v ) );
+		pushAccumulators( mSamples.back() );
+		fit();
+		++mGeneration;
+		if ( !mTriggers.empty() ) {
+			runTriggers( 1 );
+		}
+	}
+
+	// Drops the oldest samples until count more will fit in the window
+	inline void trim( size_t count )
+	{
+		clampNumSamples();
+		size_t limit = count < mNumSamples ? mNumSamples - count : 0;
+		if ( mSamples.size() > limit ) {
+			evict( mSamples.size() - limit );
+		}
+	}
+
+	// Lets a process that takes no arguments stand in for one that takes the window
+	template<typename F>
+	struct NullaryProcessT
+	{
+		F	mFunc;
+
+		inline Y operator()( const Window& )
+		{
+			return mFunc();
+		}
+	};
+
+	template<typename F>
+	static inline auto makeProcess( F&& func, int ) -> decltype( func( std::declval<const Window&>() ), Process() )
+	{
+		return Process( std::forward<F>( func ) );
+	}
+
+	static inline Process makeProcess( std::nullptr_t, int )
+	{
+		return Process();
+	}
+
+	template<typename F>
+	static inline Process makeProcess( F&& func, long )
+	{
+		if ( Process::isNull( func ) ) {
+			return Process();
+		}
+		return Process( NullaryProcessT<typename std::decay<F>::type>{ std::forward<F>( func ) } );
+	}
+
+	// The runnable process under index, or nullptr with the reason in error
+	inline const Process* findProcess( size_t index, ProcessError& error ) const noexcept
+	{
+		const Process* func = mProcessMap.get( index );
+		if ( func == nullptr ) {
+			error = PROCESS_NOT_FOUND;
+			return nullptr;
+		}
+		if ( *func == nullptr ) {
+			error = PROCESS_UNDEFINED;
+			return nullptr;
+		}
+		error = PROCESS_NONE;
+		return func;
+	}
+
+	template<typename R>
+	inline const TypedProcess& resolveTyped( const ProcessHandleT<R>& handle ) const
+	{
+		const TypedProcess* entry = mTypedProcesses.get( handle.getIndex() );
+		if ( entry == nullptr || entry->mType != &TypeTagT<R>::kId ) {
+			SAMPLING_THROW( ExcProcNotFound( handle.getIndex() ) );
+		}
+		return *entry;
+	}
+
+	// The runnable process under index; throws if there is none
+	inline const Process& resolveProcess( size_t index ) const
+	{
+		ProcessError error;
+		const Process* func = findProcess( index, error );
+		if ( error == PROCESS_NOT_FOUND ) {
+			SAMPLING_THROW( ExcProcNotFound( index ) );
+		}
+		if ( error == PROCESS_UNDEFINED ) {
+			SAMPLING_THROW( ExcProcUndefined( index ) );
+		}
+		return *func;
+	}
+public:
+	SamplerT( size_t numSamples = DefaultNumSamplesT<S>::value )
+		: mNumPadding( 0 ), mNumSamples( numSamples ), mPadded( true ), mCaching( false ), mGeneration( 1 ),
+		mEditGeneration( 1 ), mNumPushed( 0 ), mNextTrigger( 0 ), mTriggerInterval( 1 ), mTriggerPending( 0 )
+	{
+	}
+
+	// Samples, processes, accumulators and kernels are allocated from allocator
+	SamplerT( size_t numSamples, const allocator_type& allocator )
+		: mNumPadding( 0 ), mNumSamples( numSamples ), mPadded( true ), mProcessMap( allocator ),
+		mSamples( allocator ), mAccumulators( allocator ), mKernels( allocator ), mCaching( false ),
+		mCache( allocator ), mGeneration( 1 ), mEditGeneration( 1 ), mNumPushed( 0 ), mGraph( allocator ), mResults( allocator ),
+		mTypedProcesses( allocator ), mTriggers( allocator ), mNextTrigger( 0 ), mTriggerInterval( 1 ), mTriggerPending( 0 )
+	{
+	}
+
+	/*
+	 * Adopts storage and the samples already in it, e.g. a MappedRingStorageT
+	 * reopened from its file. Existing samples count as real samples, not
+	 * padding, and the oldest are evicted if there are more than numSamples.
+	 */
+	SamplerT( size_t numSamples, S&& storage )
+		: mNumPadding( 0 ), mNumSamples( numSamples ), mPadded( true ), mProcessMap( storage.getAllocator() ),
+		mSamples( std::move( storage ) ), mAccumulators( mSamples.getAllocator() ), mKernels( mSamples.getAllocator() ),
+		mCaching( false ), mCache( mSamples.getAllocator() ), mGeneration( 1 ), mEditGeneration( 1 ), mNumPushed( 0 ),
+		mGraph( mSamples.getAllocator() ), mResults( mSamples.getAllocator() ), mTypedProcesses( mSamples.getAllocator() ),
+		mTriggers( mSamples.getAllocator() ), mNextTrigger( 0 ), mTriggerInterval( 1 ), mTriggerPending( 0 )
+	{
+		fit();
+	}
+	
+	// The copy allocates from rhs's allocator, e.g. the same pmr arena
+	SamplerT( const SamplerT& rhs )
+		: mNumPadding( 0 ), mNumSamples( rhs.mNumSamples ), mPadded( true ), mProcessMap( rhs.getAllocator() ),
+		mSamples( rhs.getAllocator() ), mAccumulators( rhs.getAllocator() ), mKernels( rhs.getAllocator() ),
+		mCaching( false ), mCache( rhs.getAllocator() ), mGeneration( 1 ), mEditGeneration( 1 ), mNumPushed( 0 ),
+		mGraph( rhs.getAllocator() ), mResults( rhs.getAllocator() ), mTypedProcesses( rhs.getAllocator() ),
+		mTriggers( rhs.getAllocator() ), mNextTrigger( 0 ), mTriggerInterval( 1 ), mTriggerPending( 0 )
+	{
+		*this = rhs;
+	}
+
+	/*
+	 * Moving keeps the accumulators and kernels themselves, so their processes
+	 * stay bound. Processes that captured rhs still refer to rhs. rhs is left
+	 * empty, with no samples or processes.
+	 */
+	SamplerT( SamplerT&& rhs )
+		: mNumPadding( 0 ), mNumSamples( rhs.mNumSamples ), mPadded( true ), mProcessMap( rhs.getAllocator() ),
+		mSamples( rhs.getAllocator() ), mAccumulators( rhs.getAllocator() ), mKernels( rhs.getAllocator() ),
+		mCaching( false ), mCache( rhs.getAllocator() ), mGeneration( 1 ), mEditGeneration( 1 ), mNumPushed( 0 ),
+		mGraph( rhs.getAllocator() ), mResults( rhs.getAllocator() ), mTypedProcesses( rhs.getAllocator() ),
+		mTriggers( rhs.getAllocator() ), mNextTrigger( 0 ), mTriggerInterval( 1 ), mTriggerPending( 0 )
+	{
+		*this = std::move( rhs );
+	}
+	
+	SamplerT& operator=( const SamplerT& rhs )
+	{
+		if ( this == &rhs ) {
+			return *this;
+		}
+		mNumPadding	= rhs.mNumPadding;
+		mNumSamples	= rhs.mNumSamples;
+		mPadded		= rhs.mPadded;
+		mProcessMap	= rhs.mProcessMap;
+		mSamples	= rhs.mSamples;
+		mExecutor	= rhs.mExecutor;
+		mCaching	= rhs.mCaching;
+		mCache		= rhs.mCache;
+		mGeneration	= rhs.mGeneration;
+		mEditGeneration	= rhs.mEditGeneration;
+		mNumPushed	= rhs.mNumPushed;
+		mSnapshot	= rhs.mSnapshot;
+		mInstrumentation = rhs.mInstrumentation;
+		mGraph		= rhs.mGraph;
+		mResults	= rhs.mResults;
+		bindNodes();
+		mTypedProcesses = rhs.mTypedProcesses;
+		mTriggers		= rhs.mTriggers;
+		mNextTrigger	= rhs.mNextTrigger;
+		mTriggerInterval = rhs.mTriggerInterval;
+		mTriggerPending	= rhs.mTriggerPending;
+		mAccumulators.clear();
+		for ( const AccumulatorEntry& entry : rhs.mAccumulators ) {
+			mAccumulators.push_back( AccumulatorEntry( entry.first, std::unique_ptr<AccumulatorT<T, Y> >( entry.second->clone() ) ) );
+			setAccumulatorProcess( entry.first, mAccumulators.back().second.get() );
+		}
+		mKernels.clear();
+		for ( const KernelEntry& entry : rhs.mKernels ) {
+			mKernels.push_back( KernelEntry( entry.first, std::unique_ptr<KernelT<T, Y> >( entry.second->clone() ) ) );
+			setKernelProcess( entry.first, mKernels.back().second.get() );
+		}
+		return *this;
+	}
+
+	SamplerT& operator=( SamplerT&& rhs )
+	{
+		if ( this == &rhs ) {
+			return *this;
+		}
+		mNumPadding		= rhs.mNumPadding;
+		mNumSamples		= rhs.mNumSamples;
+		mPadded			= rhs.mPadded;
+		mProcessMap		= std::move( rhs.mProcessMap );
+		mSamples		= std::move( rhs.mSamples );
+		mAccumulators	= std::move( rhs.mAccumulators );
+		mKernels		= std::move( rhs.mKernels );
+		mExecutor		= std::move( rhs.mExecutor );
+		mCaching		= rhs.mCaching;
+		mCache			= std::move( rhs.mCache );
+		mGeneration		= rhs.mGeneration;
+		mEditGeneration	= rhs.mEditGeneration;
+		mNumPushed		= rhs.mNumPushed;
+		mSnapshot		= std::move( rhs.mSnapshot );
+		mInstrumentation = std::move( rhs.mInstrumentation );
+		mGraph			= std::move( rhs.mGraph );
+		mResults		= std::move( rhs.mResults );
+		bindNodes();
+		mTypedProcesses	= std::move( rhs.mTypedProcesses );
+		mTriggers		= std::move( rhs.mTriggers );
+		mNextTrigger	= rhs.mNextTrigger;
+		mTriggerInterval = rhs.mTriggerInterval;
+		mTriggerPending	= rhs.mTriggerPending;
+
+		rhs.mNumPadding	= 0;
+		rhs.mSamples.clear();
+		rhs.clearProcesses();
+		rhs.mExecutor	= nullptr;
+		rhs.markEdited();
+		return *this;
+	}
+
+	/*
+	 * Attaches a copy of accumulator and registers a process under index
+	 * that returns its current value. The accumulator is fed the current
+	 * window, then kept up to date on every change to the samples.
+	 */
+	template<typename A>
+	inline SamplerT& accumulate( size_t index, const A& accumulator )
+	{
+		eraseAccumulator( index );
+		AccumulatorT<T, Y>* a = new A( accumulator );
+		mAccumulators.push_back( AccumulatorEntry( index, std::unique_ptr<AccumulatorT<T, Y> >( a ) ) );
+		a->clear();
+		mSamples.getWindow().forEach( [ a ]( const T& v )
+		{
+			a->push( v );
+		} );
+		setAccumulatorProcess( index, a );
+		return *this;
+	}
+
+	inline void eraseAccumulator( size_t index )
+	{
+		for ( size_t i = 0; i < mAccumulators.size(); ++i ) {
+			if ( mAccumulators[ i ].first == index ) {
+				mAccumulators.erase( mAccumulators.begin() + i );
+				mProcessMap.erase( index );
+				dropCached( index );
+				return;
+			}
+		}
+	}
+
+	inline AccumulatorT<T, Y>* getAccumulator( size_t index ) const
+	{
+		for ( const AccumulatorEntry& entry : mAccumulators ) {
+			if ( entry.first == index ) {
+				return entry.second.get();
+			}
+		}
+		return nullptr;
+	}
+
+	// Call after editing samples through getSamples() to resync accumulators
+	inline void resetAccumulators()
+	{
+		for ( AccumulatorEntry& entry : mAccumulators ) {
+			AccumulatorT<T, Y>* a = entry.second.get();
+			a->clear();
+			mSamples.getWindow().forEach( [ a ]( const T& v )
+			{
+				a->push( v );
+			} );
+		}
+	}
+
+	/*
+	 * Attaches a copy of kernel and registers a process under index that
+	 * runs it over the window. runProcesses() and runAll() fuse the passes of
+	 * every kernel they are asked for into one traversal.
+	 */
+	template<typename K>
+	inline SamplerT& kernel( size_t index, const K& kernel )
+	{
+		eraseKernel( index );
+		KernelT<T, Y>* k = new K( kernel );
+		mKernels.push_back( KernelEntry( index, std::unique_ptr<KernelT<T, Y> >( k ) ) );
+		setKernelProcess( index, k );
+		return *this;
+	}
+
+	inline void eraseKernel( size_t index )
+	{
+		for ( size_t i = 0; i < mKernels.size(); ++i ) {
+			if ( mKernels[ i ].first == index ) {
+				mKernels.erase( mKernels.begin() + i );
+				mProcessMap.erase( index );
+				dropCached( index );
+				return;
+			}
+		}
+	}
+
+	inline KernelT<T, Y>* getKernel( size_t index ) const
+	{
+		for ( const KernelEntry& entry : mKernels ) {
+			if ( entry.first == index ) {
+				return entry.second.get();
+			}
+		}
+		return nullptr;
+	}
+
+	/*
+	 * Registers func under index. Any callable returning Y is accepted and
+	 * stored as a Process, inline when its captures fit, so a lambda is
+	 * neither wrapped in a std::function nor heap-allocated. A process that
+	 * takes a const Window& is handed the window to read each time it runs,
+	 * so it needs no reference to the sampler and can be shared between
+	 * samplers or run on other windows; one that takes nothing is called as
+	 * is.
+	 */
+	template<typename F>
+	inline SamplerT& process( size_t index, F&& func )
+	{
+		setProcess( index, std::forward<F>( func ) );
+		return *this;
+	}
+
+	inline void	clearProcesses()
+	{
+		mAccumulators.clear();
+		mKernels.clear();
+		mProcessMap.clear();
+		mCache.clear();
+		mGraph.clear();
+		mResults.clear();
+		mTypedProcesses.clear();
+		mTriggers.clear();
+	}
+
+	inline void	eraseProcess( size_t index )
+	{
+		if ( mProcessMap.count( index ) == 0 ) {
+			SAMPLING_THROW( ExcProcNotFound( index ) );
+		}
+		eraseAccumulator( index );
+		eraseKernel( index );
+		mProcessMap.erase( index );
+		if ( mGraph.erase( index ) > 0 || !mGraph.empty() ) {
+			dropResults();
+		}
+		dropCached( index );
+		for ( size_t i = mTriggers.size(); i > 0; --i ) {
+			if ( mTriggers[ i - 1 ].mIndex == index ) {
+				mTriggers.erase( mTriggers.begin() + ( i - 1 ) );
+			}
+		}
+	}
+
+	inline Process& getProcess( size_t index )
+	{
+		Process* func = mProcessMap.get( index );
+		if ( func != nullptr ) {
+			return *func;
+		}
+		SAMPLING_THROW( ExcProcNotFound( index ) );
+	}
+
+	inline const Process& getProcess( size_t index ) const
+	{
+		const Process* func = mProcessMap.get( index );
+		if ( func != nullptr ) {
+			return *func;
+		}
+		SAMPLING_THROW( ExcProcNotFound( index ) );
+	}
+
+	template<typename F>
+	inline void setProcess( size_t index, F&& func )
+	{
+		mProcessMap[ index ] = makeProcess( std::forward<F>( func ), 0 );
+		if ( mGraph.erase( index ) > 0 || !mGraph.empty() ) {
+			dropResults();
+		}
+		dropCached( index );
+	}
+
+	/*
+	 * Registers func under index as a function of the processes in inputs,
+	 * called with the window and their results in the order given:
+	 *
+	 *	sampler.process( ID_MEAN, mean );
+	 *	sampler.process( ID_VARIANCE, { ID_MEAN }, variance );
+	 *	sampler.process( ID_ZSCORE, { ID_MEAN, ID_VARIANCE }, []( const Window& window, const float* in )
+	 *	{
+	 *		return ( window.back() - in[ 0 ] ) / std::sqrt( in[ 1 ] );
+	 *	} );
+	 *
+	 * Running such a process evaluates its inputs first, depth first, and
+	 * keeps every result on this sampler's window for the rest of that run,
+	 * so shared inputs run once however many processes read them. With
+	 * caching on the results last until the samples change, so later runs
+	 * reuse them too; with it off a plain process is never served from
+	 * them outside a graph evaluation. runProcessesParallel() evaluates
+	 * independent inputs concurrently. Inputs must be registered first: an
+	 * unknown input throws ExcProcNotFound, and one that depends on index
+	 * throws ExcProcCycle. An input erased later makes runProcess() throw
+	 * and tryRunProcess() return the error for it.
+	 */
+	template<typename F>
+	inline SamplerT& process( size_t index, const std::vector<size_t>& inputs, F&& func )
+	{
+		setProcess( index, inputs, std::forward<F>( func ) );
+		return *this;
+	}
+
+	template<typename F>
+	inline void setProcess( size_t index, const std::vector<size_t>& inputs, F&& func )
+	{
+		for ( size_t input : inputs ) {
+			if ( dependsOn( input, index ) ) {
+				SAMPLING_THROW( ExcProcCycle( index ) );
+			}
+			if ( mProcessMap.count( input ) == 0 ) {
+				SAMPLING_THROW( ExcProcNotFound( input ) );
+			}
+		}
+		Node& node		= mGraph[ index ];
+		node.mFunc		= std::forward<F>( func );
+		node.mInputs	= inputs;
+		bindNode( index );
+		dropResults();
+	}
+
+	// The inputs of the process under index; empty unless it has any
+	inline const std::vector<size_t>& getInputs( size_t index ) const
+	{
+		static const std::vector<size_t> kNone;
+		const Node* node = mGraph.get( index );
+		return node != nullptr ? node->mInputs : kNone;
+	}
+
+	/*
+	 * Registers func, which returns R, under handle. One sampler's window
+	 * can feed scalar, vector and histogram results this way without a
+	 * second sampler over the same samples, or a variant Y:
+	 *
+	 *	sampler.process( ID_SPECTRUM, []( const Window& window )
+	 *	{
+	 *		return spectrum( window );
+	 *	} );
+	 *	std::vector<float> bins = sampler.runProcess( ID_SPECTRUM );
+	 *
+	 * Typed processes are left out of caching, the graph and the batch runs,
+	 * which all hold Y; func may take the window or nothing. func is moved
+	 * in, so it may be move-only; copies of the sampler then share it.
+	 */
+	template<typename R, typename F>
+	inline SamplerT& process( const ProcessHandleT<R>& handle, F&& func )
+	{
+		setProcess( handle, std::forward<F>( func ) );
+		return *this;
+	}
+
+	template<typename R, typename F>
+	inline void setProcess( const ProcessHandleT<R>& handle, F&& func )
+	{
+		typedef typename std::decay<F>::type Func;
+		static_assert( std::is_convertible<decltype( invokeTyped( std::declval<Func&>(), std::declval<const Window&>(), 0 ) ), R>::value,
+			"The process must return the handle's result type" );
+		TypedProcess& entry	= mTypedProcesses[ handle.getIndex() ];
+		entry.mFunc			= TypedHolderT<R, Func>( std::forward<F>( func ) );
+		entry.mType			= &TypeTagT<R>::kId;
+	}
+
+	// Registers func under the lowest free typed ID and returns its handle
+	template<typename F>
+	inline auto addProcess( F&& func ) -> ProcessHandleT<typename std::decay<decltype( invokeTyped( func, std::declval<const Window&>(), 0 ) )>::type>
+	{
+		size_t index = 0;
+		while ( mTypedProcesses.count( index ) > 0 ) {
+			++index;
+		}
+		ProcessHandleT<typename std::decay<decltype( invokeTyped( func, std::declval<const Window&>(), 0 ) )>::type> handle( index );
+		setProcess( handle, std::forward<F>( func ) );
+		return handle;
+	}
+
+	template<typename R>
+	inline void eraseProcess( const ProcessHandleT<R>& handle )
+	{
+		resolveTyped( handle );
+		mTypedProcesses.erase( handle.getIndex() );
+	}
+
+	template<typename R>
+	inline R runProcess( const ProcessHandleT<R>& handle ) const
+	{
+		return runProcess( handle, mSamples.getWindow() );
+	}
+
+	// Throws ExcProcNotFound if handle names nothing, or a process of another type
+	template<typename R>
+	inline R runProcess( const ProcessHandleT<R>& handle, const Window& window ) const
+	{
+		const TypedProcess& entry = resolveTyped( handle );
+		typename std::aligned_storage<sizeof( R ), alignof( R )>::type storage;
+		entry.mFunc( window, &storage );
+		R* value = reinterpret_cast<R*>( &storage );
+		R result( std::move( *value ) );
+		value->~R();
+		return result;
+	}
+
+	/*
+	 * Subscribes callback to process index instead of polling it. The
+	 * process runs as part of pushBack() and append(), once per call however
+	 * many samples a block holds, and callback receives a TriggerEventT
+	 * whenever condition holds against threshold. The first run only
+	 * records the value. Processes that are accumulators, or cached results
+	 * the frame needs anyway, make this close to free. Returns an ID for
+	 * eraseTrigger(). Callbacks must not change the sampler or its triggers;
+	 * erasing the process erases its triggers. A trigger whose process is
+	 * missing or undefined, or has a missing graph input, is skipped, so a
+	 * push never throws on its account.
+	 */
+	template<typename F>
+	inline size_t trigger( size_t index, TriggerCondition condition, const Y& threshold, F&& callback )
+	{
+		TriggerEntry entry;
+		entry.mId		= mNextTrigger++;
+		entry.mIndex	= index;
+		entry.mPrimed	= false;
+		entry.mPrevious	= Y();
+		entry.mCallback	= std::forward<F>( callback );
+		entry.mTest		= [ condition, threshold ]( const Y& previous, const Y& value ) -> bool
+		{
+			switch ( condition ) {
+			case TRIGGER_CROSSING:
+				return ( previous < threshold ) != ( value < threshold );
+			case TRIGGER_FALLING:
+				return !( previous < threshold ) && value < threshold;
+			case TRIGGER_RATE:
+				return value < previous ? !( previous - value < threshold ) : !( value - previous < threshold );
+			case TRIGGER_RISING:
+				return previous < threshold && !( value < threshold );
+			}
+			return false;
+		};
+		mTriggers.push_back( std::move( entry ) );
+		return mTriggers.back().mId;
+	}
+
+	inline void eraseTrigger( size_t id )
+	{
+		for ( size_t i = 0; i < mTriggers.size(); ++i ) {
+			if ( mTriggers[ i ].mId == id ) {
+				mTriggers.erase( mTriggers.begin() + i );
+				return;
+			}
+		}
+	}
+
+	inline void clearTriggers()
+	{
+		mTriggers.clear();
+		mTriggerPending = 0;
+	}
+
+	inline size_t getTriggerInterval() const
+	{
+		return mTriggerInterval;
+	}
+
+	/*
+	 * Runs triggers only once at least numSamples samples arrived since
+	 * they last ran, bounding their cost per sample. TRIGGER_RATE then
+	 * compares values that far apart.
+	 */
+	inline void setTriggerInterval( size_t numSamples )
+	{
+		mTriggerInterval = numSamples > 0 ? numSamples : 1;
+	}
+
+	inline ProcessMap& getProcessMap()
+	{
+		return mProcessMap;
+	}
+
+	inline const ProcessMap& getProcessMap() const
+	{
+		return mProcessMap;
+	}
+
+	inline Y runProcess( size_t index )
+	{
+		const Y* cached = findCached( index );
+		if ( cached == nullptr && mCaching && !mGraph.empty() ) {
+			cached = findResult( index );
+		}
+		if ( cached != nullptr ) {
+			mInstrumentation.onCacheHit( index );
+			return *cached;
+		}
+		// The process may run others that grow the cache, so store afterwards
+		uint64_t start = I::now();
+		Y value = resolveProcess( index )( mSamples.getWindow() );
+		mInstrumentation.onProcess( index, I::now() - start, mGeneration );
+		storeCached( index, value );
+		return value;
+	}
+
+	/*
+	 * Runs a process on window instead of this sampler's samples, e.g. a
+	 * snapshot, a sub-range or another sampler's window, bypassing the
+	 * cache. Processes registered without a window argument, and those of
+	 * accumulators, ignore it and report on this sampler as usual.
+	 */
+	inline Y runProcess( size_t index, const Window& window ) const
+	{
+		uint64_t start = I::now();
+		Y value = resolveProcess( index )( window );
+		mInstrumentation.onProcess( index, I::now() - start, 0 );
+		return value;
+	}
+
+	/*
+	 * runProcess() for loops that would rather branch than throw: writes
+	 * the result to result and returns PROCESS_NONE, or returns why there
+	 * is no process to run and leaves result alone. The lookup never
+	 * throws, so this works with exceptions disabled; the process itself
+	 * must not throw either.
+	 */
+	inline ProcessError tryRunProcess( size_t index, Y& result ) noexcept
+	{
+		const Y* cached = findCached( index );
+		if ( cached == nullptr && mCaching && !mGraph.empty() ) {
+			cached = findResult( index );
+		}
+		if ( cached != nullptr ) {
+			mInstrumentation.onCacheHit( index );
+			result = *cached;
+			return PROCESS_NONE;
+		}
+		uint64_t start		= I::now();
+		ProcessError error	= runChecked( index, mSamples.getWindow(), result );
+		if ( error == PROCESS_NONE ) {
+			mInstrumentation.onProcess( index, I::now() - start, mGeneration );
+			storeCached( index, result );
+		}
+		return error;
+	}
+
+	// Graph processes report a missing or undefined input the same way
+	inline ProcessError tryRunProcess( size_t index, const Window& window, Y& result ) const noexcept
+	{
+		uint64_t start		= I::now();
+		ProcessError error	= runChecked( index, window, result );
+		if ( error == PROCESS_NONE ) {
+			mInstrumentation.onProcess( index, I::now() - start, 0 );
+		}
+		return error;
+	}
+
+	/*
+	 * With caching on, runProcess() and the batch runs return the result a
+	 * process produced earlier as long as no samples have changed since.
+	 * Every call that modifies the window starts a new generation. Processes
+	 * must then depend only on the samples; call invalidate() after changing
+	 * anything else they read, including samples edited through getWindow().
+	 * The non-const getSamples() starts a new generation itself. Caching
+	 * makes runProcess() write to the sampler, so concurrent callers need
+	 * their own synchronization.
+	 */
+	inline void setCaching( bool caching )
+	{
+		mCaching = caching;
+		mCache.clear();
+		mResults.clear();
+	}
+
+	inline bool isCaching() const
+	{
+		return mCaching;
+	}
+
+	// Changes whenever the samples do; never zero
+	inline uint64_t getGeneration() const
+	{
+		return mGeneration;
+	}
+
+	// Empty unless the sampler was built with an instrumentation policy
+	inline const SamplerStats& getStats() const
+	{
+		return mInstrumentation.getStats();
+	}
+
+	inline void resetStats()
+	{
+		mInstrumentation.resetStats();
+	}
+
+	/*
+	 * Returns an immutable view of the window. With RingStorageT this costs
+	 * O(1) and copies nothing: the snapshot pins the ring's buffer, and only
+	 * if a snapshot is still alive at the next write does the sampler move
+	 * its live samples to a fresh buffer, once. Snapshots released before
+	 * the next push cost no copy at all. Other storage policies cannot share
+	 * their buffer, so the window is copied instead, at most once per
+	 * generation. Call it from the thread that owns the sampler; the
+	 * snapshot itself can be read anywhere.
+	 */
+	inline Snapshot snapshot()
+	{
+		return makeSnapshot( mSamples, 0 );
+	}
+
+	// Drops cached results and resyncs accumulators after outside edits
+	inline void invalidate()
+	{
+		markEdited();
+		resetAccumulators();
+	}
+
+	// A full frame holding every valid sample, for a new consumer
+	inline WindowExport exportWindow() const
+	{
+		ExportCursor cursor;
+		return exportWindow( cursor );
+	}
+
+	/*
+	 * Exports the window for a consumer that has seen everything up to
+	 * cursor, then advances cursor. While the sampler only received
+	 * pushBack() and append() calls since the last export, and the window
+	 * still holds every sample pushed since, the frame is a delta carrying
+	 * just those samples, so streaming costs as much as the ingest rate and
+	 * not the window size. Any other change, or a default cursor, gives a
+	 * full frame. Either way the buffers reference the samples in place:
+	 *
+	 *	ExportCursor cursor;
+	 *	...
+	 *	sampler.exportWindow( cursor ).writeTo( socket );
+	 */
+	inline WindowExport exportWindow( ExportCursor& cursor ) const
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "exportWindow() requires a trivially copyable sample type" );
+		uint64_t count	= mNumPushed - cursor.sequence;
+		bool delta		= cursor.generation >= mEditGeneration && cursor.generation <= mGeneration &&
+			count <= getNumValidSamples();
+		if ( !delta ) {
+			count = getNumValidSamples();
+		}
+
+		ExportHeader header;
+		header.magic		= ExportHeader::kMagic;
+		header.version		= ExportHeader::kVersion;
+		header.mode			= delta ? EXPORT_DELTA : EXPORT_FULL;
+		header.sampleSize	= (uint16_t)sizeof( T );
+		header.count		= count;
+		header.numSamples	= mNumSamples;
+		header.generation	= mGeneration;
+		header.baseSequence	= mNumPushed - count;
+		header.sequence		= mNumPushed;
+
+		cursor.generation	= mGeneration;
+		cursor.sequence		= mNumPushed;
+		return WindowExport( header, mSamples.getWindow().tail( (size_t)count ) );
+	}
+
+	/*
+	 * Applies a frame from exportWindow(), given as one contiguous buffer. A
+	 * full frame replaces the samples and the window size; a delta is pushed
+	 * onto them. Returns false, leaving the sampler as it was, if the frame
+	 * is malformed, holds a different sample type or a window too large
+	 * for size_t, or is a delta that does not follow the last frame
+	 * applied here.
+	 */
+	inline bool importWindow( const void* data, size_t size )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "importWindow() requires a trivially copyable sample type" );
+		ExportHeader header;
+		if ( size < sizeof( ExportHeader ) ) {
+			return false;
+		}
+		std::memcpy( &header, data, sizeof( ExportHeader ) );
+		size_t bytes = size - sizeof( ExportHeader );
+		if ( header.magic != ExportHeader::kMagic || header.version != ExportHeader::kVersion || header.sampleSize != sizeof( T ) ||
+			bytes % sizeof( T ) != 0 || bytes / sizeof( T ) != header.count ||
+			header.numSamples > std::numeric_limits<size_t>::max() ) {
+			return false;
+		}
+		if ( header.mode == EXPORT_DELTA ) {
+			if ( header.baseSequence != mNumPushed ) {
+				return false;
+			}
+		} else if ( header.mode == EXPORT_FULL ) {
+			clearSamples();
+			setNumSamples( (size_t)header.numSamples );
+		} else {
+			return false;
+		}
+
+		const unsigned char* samples = static_cast<const unsigned char*>( data ) + sizeof( ExportHeader );
+		if ( reinterpret_cast<uintptr_t>( samples ) % alignof( T ) == 0 ) {
+			append( reinterpret_cast<const T*>( samples ), (size_t)header.count );
+		} else {
+			std::vector<T> aligned( (size_t)header.count );
+			std::memcpy( aligned.data(), samples, bytes );
+			append( aligned.data(), aligned.size() );
+		}
+		mNumPushed = header.sequence;
+		return true;
+	}
+
+	/*
+	 * Runs the processes in indices and writes their results, in the same
+	 * order, to results. Kernels among them are evaluated together in one
+	 * pass over the window, once however often they are listed; everything
+	 * else runs as runProcess() would.
+	 */
+	inline void runProcesses( const size_t* indices, size_t count, Y* results )
+	{
+		uint64_t start = I::now();
+		mBatchKernels.assign( count, nullptr );
+		mBatchRepeats.clear();
+		size_t fused = 0;
+		for ( size_t i = 0; i < count; ++i ) {
+			KernelT<T, Y>* k = findCached( indices[ i ] ) == nullptr ? getKernel( indices[ i ] ) : nullptr;
+			if ( k != nullptr && std::find( mBatchKernels.begin(), mBatchKernels.begin() + i, k ) != mBatchKernels.begin() + i ) {
+				mBatchRepeats.push_back( i );
+			} else if ( k != nullptr ) {
+				k->begin();
+				mBatchKernels[ i ] = k;
+				++fused;
+			}
+		}
+		if ( fused > 0 ) {
+			// Blocks small enough to stay in L1 while every kernel reads them
+			const size_t blockSize = 4096 / sizeof( T ) > 0 ? 4096 / sizeof( T ) : 1;
+			WindowT<const T> window = mSamples.getWindow();
+			const SpanT<const T>* segments[] = { &window.first(), &window.second() };
+			for ( const SpanT<const T>* segment : segments ) {
+				for ( size_t offset = 0; offset < segment->size(); offset += blockSize ) {
+					size_t n = segment->size() - offset < blockSize ? segment->size() - offset : blockSize;
+					SpanT<const T> block = segment->subspan( offset, n );
+					for ( KernelT<T, Y>* k : mBatchKernels ) {
+						if ( k != nullptr ) {
+							k->update( block );
+						}
+					}
+				}
+			}
+		}
+		uint64_t share = fused > 0 ? ( I::now() - start ) / fused : 0;
+		size_t repeat = 0;
+		for ( size_t i = 0; i < count; ++i ) {
+			if ( repeat < mBatchRepeats.size() && mBatchRepeats[ repeat ] == i ) {
+				KernelT<T, Y>* k = getKernel( indices[ i ] );
+				results[ i ] = results[ std::find( mBatchKernels.begin(), mBatchKernels.end(), k ) - mBatchKernels.begin() ];
+				++repeat;
+			} else if ( mBatchKernels[ i ] != nullptr ) {
+				results[ i ] = mBatchKernels[ i ]->end();
+				mInstrumentation.onProcess( indices[ i ], share, mGeneration );
+				storeCached( indices[ i ], results[ i ] );
+			} else {
+				results[ i ] = runProcess( indices[ i ] );
+			}
+		}
+	}
+
+	inline void runProcesses( const std::vector<size_t>& indices, std::vector<Y>& results )
+	{
+		results.resize( indices.size() );
+		runProcesses( indices.data(), indices.size(), results.data() );
+	}
+
+	/*
+	 * Runs every registered process in ascending ID order. results must have
+	 * room for getProcessMap().size() values. Returns the number written.
+	 */
+	inline size_t runAll( Y* results )
+	{
+		mBatchIndices.clear();
+		for ( const typename ProcessMap::Entry& entry : mProcessMap ) {
+			mBatchIndices.push_back( entry.first );
+		}
+		runProcesses( mBatchIndices.data(), mBatchIndices.size(), results );
+		return mBatchIndices.size();
+	}
+
+	inline void runAll( std::vector<Y>& results )
+	{
+		results.resize( mProcessMap.size() );
+		runAll( results.data() );
+	}
+
+	inline const Executor& getExecutor() const
+	{
+		return mExecutor;
+	}
+
+	// Pass nullptr to run everything on the calling thread again
+	inline void setExecutor( const Executor& executor )
+	{
+		mExecutor = executor;
+	}
+
+	/*
+	 * Runs the processes in indices concurrently on the executor and writes
+	 * their results, in order, to results. The calling thread runs one of
+	 * them itself and returns once all are done; the first exception thrown
+	 * by a process is rethrown here. An ID listed more than once runs once.
+	 * Kernels keep state while they run, so kernel() processes run one after
+	 * another on the calling thread. Everything else runs concurrently:
+	 * accumulate() processes only read their accumulator, and process()
+	 * functions must only read the sampler and be safe to call at the same
+	 * time as each other, sharing no unsynchronised state. The sampler must
+	 * not be modified until this returns. Without an executor this is
+	 * runProcesses().
+	 */
+	inline void runProcessesParallel( const size_t* indices, size_t count, Y* results )
+	{
+		if ( mExecutor == nullptr || count < 2 ) {
+			runProcesses( indices, count, results );
+			return;
+		}
+
+		// Resolve every ID up front so a bad one throws before anything is
+		// queued. Graph inputs are evaluated first, then cached results and
+		// those of this evaluation are filled in here and only misses dispatched.
+		if ( !mGraph.empty() ) {
+			evaluateGraph( indices, count );
+		}
+		mBatchMisses.clear();
+		mBatchProcesses.clear();
+		mBatchRepeats.clear();
+		mBatchSerial.clear();
+		mBatchFirsts.clear();
+		for ( size_t i = 0; i < count; ++i ) {
+			const Y* cached = findCached( indices[ i ] );
+			if ( cached == nullptr && !mGraph.empty() ) {
+				cached = findResult( indices[ i ] );
+			}
+			if ( cached != nullptr ) {
+				mInstrumentation.onCacheHit( indices[ i ] );
+				results[ i ] = *cached;
+				continue;
+			}
+			const Process* func = &resolveProcess( indices[ i ] );
+			if ( indices[ i ] >= mBatchFirsts.size() ) {
+				mBatchFirsts.resize( indices[ i ] + 1, count );
+			}
+			size_t& first = mBatchFirsts[ indices[ i ] ];
+			if ( first < count ) {
+				mBatchRepeats.push_back( i );
+				continue;
+			}
+			first = i;
+			if ( getKernel( indices[ i ] ) != nullptr ) {
+				mBatchSerial.push_back( i );
+			} else {
+				mBatchMisses.push_back( i );
+				mBatchProcesses.push_back( func );
+			}
+		}
+
+		const size_t*			misses		= mBatchMisses.data();
+		const Process**			processes	= mBatchProcesses.data();
+		const Window			window		= mSamples.getWindow();
+		if ( I::kEnabled ) {
+			mBatchTimes.resize( mBatchMisses.size() );
+		}
+		uint64_t*				times		= mBatchTimes.data();
+		runParallel( mBatchMisses.size(), [ & ]( size_t i )
+		{
+			uint64_t start = I::now();
+			results[ misses[ i ] ] = ( *processes[ i ] )( window );
+			if ( I::kEnabled ) {
+				times[ i ] = I::now() - start;
+			}
+		} );
+		for ( size_t i = 0; i < mBatchMisses.size(); ++i ) {
+			if ( I::kEnabled ) {
+				mInstrumentation.onProcess( indices[ mBatchMisses[ i ] ], times[ i ], mGeneration );
+			}
+			storeCached( indices[ mBatchMisses[ i ] ], results[ mBatchMisses[ i ] ] );
+		}
+		for ( size_t i : mBatchSerial ) {
+			uint64_t start	= I::now();
+			results[ i ]	= resolveProcess( indices[ i ] )( window );
+			mInstrumentation.onProcess( indices[ i ], I::now() - start, mGeneration );
+			storeCached( indices[ i ], results[ i ] );
+		}
+		for ( size_t i : mBatchRepeats ) {
+			results[ i ] = results[ mBatchFirsts[ indices[ i ] ] ];
+		}
+	}
+
+	inline void runProcessesParallel( const std::vector<size_t>& indices, std::vector<Y>& results )
+	{
+		results.resize( indices.size() );
+		runProcessesParallel( indices.data(), indices.size(), results.data() );
+	}
+
+	/*
+	 * Queues one process on the executor, or runs it immediately without
+	 * one. The sampler must not be modified until the future is ready.
+	 */
+	inline std::future<Y> runProcessAsync( size_t index )
+	{
+		const Process* func = &resolveProcess( index );
+		std::shared_ptr<std::promise<Y> > promise = std::make_shared<std::promise<Y> >();
+		std::future<Y> future = promise->get_future();
+		const Window window = mSamples.getWindow();
+		std::function<void()> task = [ func, promise, window ]()
+		{
+#if defined( SAMPLING_EXCEPTIONS )
+			try {
+				promise->set_value( ( *func )( window ) );
+			} catch ( ... ) {
+				promise->set_exception( std::current_exception() );
+			}
+#else
+			promise->set_value( ( *func )( window ) );
+#endif
+		};
+		if ( mExecutor == nullptr ) {
+			task();
+		} else {
+			mExecutor( task );
+		}
+		return future;
+	}
+
+	inline allocator_type getAllocator() const
+	{
+		return mSamples.getAllocator();
+	}
+
+	inline size_t getNumSamples() const
+	{
+		return mNumSamples;
+	}
+	
+	/*
+	 * Growing reserves room up front so filling the window does not
+	 * reallocate; shrinking evicts only the samples that no longer fit and
+	 * keeps the allocation. Call shrinkToFit() to release it.
+	 */
+	inline void setNumSamples( size_t numSamples )
+	{
+		mNumSamples = numSamples;
+		clampNumSamples();
+		mSamples.reserve( mNumSamples );
+		fit();
+		markEdited();
+	}
+
+	// Number of samples in the window that were not added as padding
+	inline size_t getNumValidSamples() const
+	{
+		return mSamples.size() - mNumPadding;
+	}
+
+	inline bool isPadded() const
+	{
+		return mPadded;
+	}
+
+	/*
+	 * A padded sampler (the default) always holds getNumSamples() values,
+	 * filling the front of the window with T() until enough samples arrive.
+	 * An unpadded sampler holds only the samples it was given, so the window
+	 * grows to getNumSamples() and then slides. Turning padding off drops any
+	 * padding currently in the window.
+	 */
+	inline void setPadded( bool padded )
+	{
+		mPadded = padded;
+		if ( !mPadded && mNumPadding > 0 ) {
+			evict( mNumPadding );
+		}
+		fit();
+		markEdited();
+	}
+
+	inline void shrinkToFit()
+	{
+		mSamples.shrinkToFit();
+	}
+
+	inline void clearSamples()
+	{
+		mSamples.clear();
+		mNumPadding = 0;
+		for ( AccumulatorEntry& entry : mAccumulators ) {
+			entry.second->clear();
+		}
+		markEdited();
+	}
+
+	// Evicts the oldest count samples as if they had slid out of the window
+	inline void popFront( size_t count = 1 )
+	{
+		count = count < mSamples.size() ? count : mSamples.size();
+		if ( count > 0 ) {
+			evict( count );
+			fit();
+			markEdited();
+		}
+	}
+
+	inline void eraseSample( size_t index )
+	{
+		if ( mSamples.size() > index ) {
+			mSamples.erase( index );
+			mNumPadding -= index < mNumPadding ? 1 : 0;
+			resetAccumulators();
+			markEdited();
+		}
+	}
+
+	// Starts a new generation, since the samples may be edited through it
+	typename S::container_type& getSamples()
+	{
+		markEdited();
+		return mSamples.container();
+	}
+
+	const typename S::container_type& getSamples() const
+	{
+		return mSamples.container();
+	}
+
+	// The storage policy itself, for processes that use its own interface
+	inline const S& getStorage() const
+	{
+		return mSamples;
+	}
+
+	inline WindowT<T> getWindow()
+	{
+		return mSamples.getWindow();
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		return mSamples.getWindow();
+	}
+
+	// Views of the current window; see WindowT::range()
+	inline Window range( size_t first, size_t last ) const
+	{
+		return getWindow().range( first, last );
+	}
+
+	inline StridedWindowT<const T> stride( size_t step ) const
+	{
+		return getWindow().stride( step );
+	}
+
+	inline Window tail( size_t count ) const
+	{
+		return getWindow().tail( count );
+	}
+
+	inline void insertSample( size_t index, const T& v )
+	{
+		// Evict before inserting so storage never holds more than a window.
+		// The result matches inserting first and trimming the front after.
+		T value( v );
+		clampNumSamples();
+		if ( mSamples.size() >= mNumSamples ) {
+			size_t count = mSamples.size() - mNumSamples + 1;
+			if ( index < count ) {
+				evict( count - 1 );
+				resetAccumulators();
+				markEdited();
+				return;
+			}
+			evict( count );
+			index -= count;
+		}
+		mSamples.insert( index, value );
+		mNumPadding = index < mNumPadding ? index : mNumPadding;
+		fit();
+		resetAccumulators();
+		markEdited();
+	}
+
+	// Copies v straight into the storage, unless it is one of the samples trim() may shift
+	inline void	pushBack( const T& v )
+	{
+		if ( isOwnSample( v ) ) {
+			pushBack( T( v ) );
+			return;
+		}
+		pushSample( v );
+	}
+
+	inline void	pushBack( T&& v )
+	{
+		pushSample( std::move( v ) );
+	}
+
+	template<typename... Args>
+	inline void	emplaceBack( Args&&... args )
+	{
+		pushBack( T( std::forward<Args>( args )... ) );
+	}
+
+	/*
+	 * Appends a block of samples, evicting the oldest ones in a single step.
+	 * Only the newest getNumSamples() values of the block are kept. The range
+	 * must not refer to this sampler's own samples.
+	 */
+	template<typename Iter>
+	inline void append( Iter first, Iter last )
+	{
+		size_t count = std::distance( first, last );
+		if ( count == 0 ) {
+			return;
+		}
+		mInstrumentation.onIngest( count );
+		mNumPushed += count;
+		clampNumSamples();
+		if ( count > mNumSamples ) {
+			std::advance( first, count - mNumSamples );
+			count = mNumSamples;
+		}
+		trim( count );
+		mSamples.append( first, last );
+		if ( !mAccumulators.empty() ) {
+			for ( size_t i = mSamples.size() - count; i < mSamples.size(); ++i ) {
+				pushAccumulators( mSamples[ i ] );
+			}
+		}
+		fit();
+		++mGeneration;
+		if ( !mTriggers.empty() ) {
+			runTriggers( count );
+		}
+	}
+
+	inline void append( const T* data, size_t count )
+	{
+		append( data, data + count );
+	}
+
+	inline void append( const SpanT<const T>& samples )
+	{
+		append( samples.begin(), samples.end() );
+	}
+};
+
+template<typename T, typename Y>
+using RingSamplerT = SamplerT<T, Y, RingStorageT<T> >;
+
+// A sampler with an inline window of at most N samples, N a power of two
+template<typename T, typename Y, size_t N>
+using FixedSamplerT = SamplerT<T, Y, FixedRingStorageT<T, N> >;
+
+#if __cplusplus >= 201703L && defined( __has_include )
+#if __has_include( <memory_resource> )
+
+/*
+ * Samplers that take their memory from a std::pmr::memory_resource, e.g.
+ *
+ *	std::pmr::monotonic_buffer_resource arena;
+ *	pmr::RingSamplerT<float, float> sampler( 1024, &arena );
+ */
+namespace pmr {
+
+template<typename T, typename Y>
+using SamplerT = sampling::SamplerT<T, Y, VectorStorageT<T, std::pmr::polymorphic_allocator<T> > >;
+
+template<typename T, typename Y>
+using RingSamplerT = sampling::SamplerT<T, Y, RingStorageT<T, std::pmr::polymorphic_allocator<T> > >;
+
+} // namespace pmr
+
+#endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Vector-valued samples stored as structure-of-arrays. Each of the
+ * Channels channels is a SamplerT of its own, so every channel's samples
+ * are contiguous and per-channel reductions read a unit-stride window,
+ * e.g. for a tracker's x, y, z and w:
+ *
+ *	MultiChannelSamplerT<float, float, 4> poses( 120 );
+ *	poses.process( ID_MEAN, []( const WindowT<const float>& window )
+ *	{
+ *		return reduce::sum( window ) / window.size();
+ *	} );
+ *	poses.pushBack( &pose.x );
+ *	poses.runProcess( ID_MEAN, means );	// one result per channel
+ *
+ * process(), accumulate() and kernel() register on every channel; use
+ * getChannel() to give a channel processes of its own. Frames passed as
+ * pointers hold one value per channel, in channel order.
+ */
+template<typename T, typename Y, size_t Channels, typename S = VectorStorageT<T> >
+class MultiChannelSamplerT
+{
+	static_assert( Channels > 0, "MultiChannelSamplerT needs at least one channel" );
+public:
+	typedef SamplerT<T, Y, S>			Channel;
+	typedef std::array<T, Channels>		Frame;
+
+	static const size_t kNumChannels = Channels;
+
+	MultiChannelSamplerT( size_t numSamples = DefaultNumSamplesT<S>::value )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.setNumSamples( numSamples );
+		}
+	}
+
+	template<typename A>
+	inline MultiChannelSamplerT& accumulate( size_t index, const A& accumulator )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.accumulate( index, accumulator );
+		}
+		return *this;
+	}
+
+	template<typename K>
+	inline MultiChannelSamplerT& kernel( size_t index, const K& kernel )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.kernel( index, kernel );
+		}
+		return *this;
+	}
+
+	// Every channel gets its own copy of func
+	template<typename F>
+	inline MultiChannelSamplerT& process( size_t index, const F& func )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.process( index, func );
+		}
+		return *this;
+	}
+
+	inline void eraseProcess( size_t index )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.eraseProcess( index );
+		}
+	}
+
+	// Writes process index of each channel to results, which has room for Channels values
+	inline void runProcess( size_t index, Y* results )
+	{
+		for ( size_t c = 0; c < Channels; ++c ) {
+			results[ c ] = mChannels[ c ].runProcess( index );
+		}
+	}
+
+	inline std::array<Y, Channels> runProcess( size_t index )
+	{
+		std::array<Y, Channels> results;
+		runProcess( index, results.data() );
+		return results;
+	}
+
+	inline Channel& getChannel( size_t channel )
+	{
+		return mChannels[ channel ];
+	}
+
+	inline const Channel& getChannel( size_t channel ) const
+	{
+		return mChannels[ channel ];
+	}
+
+	inline size_t getNumChannels() const
+	{
+		return Channels;
+	}
+
+	inline size_t getNumSamples() const
+	{
+		return mChannels[ 0 ].getNumSamples();
+	}
+
+	inline void setNumSamples( size_t numSamples )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.setNumSamples( numSamples );
+		}
+	}
+
+	inline size_t getNumValidSamples() const
+	{
+		return mChannels[ 0 ].getNumValidSamples();
+	}
+
+	inline void setPadded( bool padded )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.setPadded( padded );
+		}
+	}
+
+	inline void setCaching( bool caching )
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.setCaching( caching );
+		}
+	}
+
+	inline void clearSamples()
+	{
+		for ( Channel& channel : mChannels ) {
+			channel.clearSamples();
+		}
+	}
+
+	// Gathers sample index of every channel
+	inline Frame getSample( size_t index ) const
+	{
+		Frame frame;
+		for ( size_t c = 0; c < Channels; ++c ) {
+			frame[ c ] = mChannels[ c ].getWindow()[ index ];
+		}
+		return frame;
+	}
+
+	inline size_t getSize() const
+	{
+		return mChannels[ 0 ].getWindow().size();
+	}
+
+	inline WindowT<T> getWindow( size_t channel )
+	{
+		return mChannels[ channel ].getWindow();
+	}
+
+	inline WindowT<const T> getWindow( size_t channel ) const
+	{
+		return mChannels[ channel ].getWindow();
+	}
+
+	inline void pushBack( const T* frame )
+	{
+		for ( size_t c = 0; c < Channels; ++c ) {
+			mChannels[ c ].pushBack( frame[ c ] );
+		}
+	}
+
+	inline void pushBack( const Frame& frame )
+	{
+		pushBack( frame.data() );
+	}
+
+	/*
+	 * Appends count interleaved frames, i.e. Channels * count values laid
+	 * out frame after frame, splitting them into each channel in one block.
+	 */
+	inline void append( const T* frames, size_t count )
+	{
+		mScratch.resize( count );
+		for ( size_t c = 0; c < Channels; ++c ) {
+			for ( size_t i = 0; i < count; ++i ) {
+				mScratch[ i ] = frames[ i * Channels + c ];
+			}
+			mChannels[ c ].append( mScratch.data(), count );
+		}
+	}
+protected:
+	std::array<Channel, Channels>	mChannels;
+	std::vector<T>					mScratch;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// The reductions SamplerBankT runs across all of its samplers at once
+enum Reduction
+{
+	REDUCE_MAX, REDUCE_MEAN, REDUCE_MIN, REDUCE_SUM
+};
+
+/*
+ * Many samplers of the same window size kept as one structure, e.g. one
+ * per metric per entity. All windows share a single slab and one process
+ * table. The slab is time-major, a ring of getNumSamples() rows of one
+ * value per sampler, so a tick is a single contiguous row copy:
+ *
+ *	SamplerBankT<float, float> bank( numEntities, 60 );
+ *	bank.process( ID_MEAN, REDUCE_MEAN );
+ *	bank.process( ID_PEAK_TO_PEAK, []( const WindowT<const float>& window )
+ *	{
+ *		return reduce::maximum( window ) - reduce::minimum( window );
+ *	} );
+ *	bank.pushBackAll( values );				// one value per sampler
+ *	bank.runProcessAll( ID_MEAN, means );		// one result per sampler
+ *
+ * For a process registered as a Reduction, runProcessAll() folds the rows
+ * into the results with reduce::addInto() and the like, so the work is
+ * SIMD across samplers and streams the slab once. Any other process sees
+ * each sampler's window as a contiguous copy, gathered a block of samplers
+ * at a time so the slab is still read row by row. getWindow() views one
+ * sampler's window in place, strided across the rows. The samplers
+ * advance in lockstep and share a head and a count. Like SamplerT, the
+ * bank pads windows with T() until they fill unless padding is turned off.
+ */
+template<typename T, typename Y, typename A = std::allocator<T> >
+class SamplerBankT
+{
+public:
+	typedef A																		allocator_type;
+	typedef WindowT<const T>														Window;
+	typedef StridedWindowT<const T>													Column;
+	typedef InplaceFunctionT<Y( const Window& )>									Process;
+	typedef ProcessTableT<Process, RebindAllocT<allocator_type, Process> >			ProcessMap;
+
+	// Samplers gathered together for a process that is not a Reduction
+	static const size_t kGatherBlock = 16;
+
+	SamplerBankT( size_t numSamplers, size_t numSamples, const allocator_type& allocator = allocator_type() )
+		: mHead( 0 ), mNumSamplers( numSamplers ), mNumSamples( numSamples > 0 ? numSamples : 1 ), mNumValid( 0 ),
+		mPadded( true ), mProcessMap( allocator ), mReductions( allocator ),
+		mSlab( numSamplers * ( numSamples > 0 ? numSamples : 1 ), T(), allocator )
+	{
+	}
+
+	template<typename F>
+	inline SamplerBankT& process( size_t index, F&& func )
+	{
+		setProcess( index, std::forward<F>( func ) );
+		return *this;
+	}
+
+	inline void eraseProcess( size_t index )
+	{
+		if ( mProcessMap.erase( index ) == 0 ) {
+			SAMPLING_THROW( ExcProcNotFound( index ) );
+		}
+		mReductions.erase( index );
+	}
+
+	inline ProcessMap& getProcessMap()
+	{
+		return mProcessMap;
+	}
+
+	inline const ProcessMap& getProcessMap() const
+	{
+		return mProcessMap;
+	}
+
+	// Processes take the window they run on; every sampler shares them
+	template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Reduction>::value>::type>
+	inline void setProcess( size_t index, F&& func )
+	{
+		mProcessMap[ index ] = Process( std::forward<F>( func ) );
+		mReductions.erase( index );
+	}
+
+	// Registers a built-in reduction, which runProcessAll() runs across samplers
+	inline void setProcess( size_t index, Reduction reduction )
+	{
+		static_assert( std::is_convertible<T, Y>::value, "Reductions need a result type convertible from T" );
+		mProcessMap[ index ] = Process( ReductionProcess( reduction ) );
+		mReductions[ index ] = reduction;
+	}
+
+	// Runs process index on one sampler's window
+	inline Y runProcess( size_t index, size_t sampler ) const
+	{
+		const Process& func = resolveProcess( index );
+		std::vector<T, A> window( mSlab.get_allocator() );
+		gather( sampler, 1, getSize(), window );
+		return func( Window( SpanT<const T>( window.data(), window.size() ) ) );
+	}
+
+	// Writes process index of each sampler to results, which has room for getNumSamplers() values
+	inline void runProcessAll( size_t index, Y* results ) const
+	{
+		const Process& func = resolveProcess( index );
+		const Reduction* reduction = mReductions.get( index );
+		if ( reduction != nullptr ) {
+			reduceAll( *reduction, results, std::is_convertible<T, Y>() );
+			return;
+		}
+		size_t size = getSize();
+		std::vector<T, A> windows( mSlab.get_allocator() );
+		for ( size_t i = 0; i < mNumSamplers; i += kGatherBlock ) {
+			size_t count = mNumSamplers - i < kGatherBlock ? mNumSamplers - i : kGatherBlock;
+			gather( i, count, size, windows );
+			for ( size_t j = 0; j < count; ++j ) {
+				results[ i + j ] = func( Window( SpanT<const T>( windows.data() + j * size, size ) ) );
+			}
+		}
+	}
+
+	inline void runProcessAll( size_t index, std::vector<Y>& results ) const
+	{
+		results.resize( mNumSamplers );
+		runProcessAll( index, results.data() );
+	}
+
+	inline size_t getNumSamplers() const
+	{
+		return mNumSamplers;
+	}
+
+	inline size_t getNumSamples() const
+	{
+		return mNumSamples;
+	}
+
+	// Number of samples in each window that were not added as padding
+	inline size_t getNumValidSamples() const
+	{
+		return mNumValid;
+	}
+
+	// Samples in each window, padding included
+	inline size_t getSize() const
+	{
+		return mPadded ? mNumSamples : mNumValid;
+	}
+
+	inline bool isPadded() const
+	{
+		return mPadded;
+	}
+
+	inline void setPadded( bool padded )
+	{
+		mPadded = padded;
+	}
+
+	inline void clearSamples()
+	{
+		std::fill( mSlab.begin(), mSlab.end(), T() );
+		mHead		= 0;
+		mNumValid	= 0;
+	}
+
+	// Row the next pushBackAll() writes, which holds the oldest samples once the windows are full
+	inline size_t getHead() const
+	{
+		return mHead;
+	}
+
+	// The whole slab, getNumSamples() rows of getNumSamplers() values
+	inline const T* getSlab() const
+	{
+		return mSlab.data();
+	}
+
+	// One sampler's window in place, oldest to newest
+	inline Column getWindow( size_t sampler ) const
+	{
+		size_t size = getSize();
+		if ( size == 0 ) {
+			return Column();
+		}
+		Window rows = getRows( size );
+		return rows.range( sampler, rows.size() - ( mNumSamplers - 1 - sampler ) ).stride( mNumSamplers );
+	}
+
+	// Pushes values[ i ] onto sampler i for every sampler
+	inline void pushBackAll( const T* values )
+	{
+		std::copy( values, values + mNumSamplers, mSlab.begin() + mHead * mNumSamplers );
+		mHead		= mHead + 1 == mNumSamples ? 0 : mHead + 1;
+		mNumValid	+= mNumValid < mNumSamples ? 1 : 0;
+	}
+
+	inline void pushBackAll( const std::vector<T>& values )
+	{
+		pushBackAll( values.data() );
+	}
+protected:
+	// Computes a Reduction over one window, for runProcess()
+	struct ReductionProcess
+	{
+		explicit ReductionProcess( Reduction reduction )
+			: mReduction( reduction )
+		{
+		}
+
+		inline Y operator()( const Window& window ) const
+		{
+			if ( window.empty() ) {
+				return Y();
+			}
+			switch ( mReduction ) {
+			case REDUCE_MAX:
+				return (Y)reduce::maximum( window );
+			case REDUCE_MEAN:
+				return (Y)reduce::sum( window ) / (Y)window.size();
+			case REDUCE_MIN:
+				return (Y)reduce::minimum( window );
+			case REDUCE_SUM:
+				return (Y)reduce::sum( window );
+			}
+			return Y();
+		}
+
+		Reduction mReduction;
+	};
+
+	size_t											mHead;
+	size_t											mNumSamplers;
+	size_t											mNumSamples;
+	size_t											mNumValid;
+	bool											mPadded;
+	ProcessMap										mProcessMap;
+	ProcessTableT<Reduction, RebindAllocT<allocator_type, Reduction> >	mReductions;
+	std::vector<T, A>								mSlab;
+
+	inline const T* getRow( size_t slot ) const
+	{
+		return mSlab.data() + slot * mNumSamplers;
+	}
+
+	// The newest size rows as one flat window, oldest row first
+	inline Window getRows( size_t size ) const
+	{
+		size_t first = mHead + mNumSamples - size;
+		first = first >= mNumSamples ? first - mNumSamples : first;
+		if ( first + size <= mNumSamples ) {
+			return Window( SpanT<const T>( getRow( first ), size * mNumSamplers ) );
+		}
+		return Window( SpanT<const T>( getRow( first ), ( mNumSamples - first ) * mNumSamplers ),
+			SpanT<const T>( getRow( 0 ), ( first + size - mNumSamples ) * mNumSamplers ) );
+	}
+
+	// Copies the windows of count samplers from first on, size samples each, into out back to back
+	inline void gather( size_t first, size_t count, size_t size, std::vector<T, A>& out ) const
+	{
+		out.resize( count * size );
+		size_t slot = mHead + mNumSamples - size;
+		for ( size_t r = 0; r < size; ++r, ++slot ) {
+			const T* row = getRow( slot >= mNumSamples ? slot - mNumSamples : slot ) + first;
+			for ( size_t j = 0; j < count; ++j ) {
+				out[ j * size + r ] = row[ j ];
+			}
+		}
+	}
+
+	// Folds the rows of every window into results, SIMD across samplers
+	inline void reduceAll( Reduction reduction, Y* results, std::true_type ) const
+	{
+		size_t size = getSize();
+		if ( size == 0 ) {
+			std::fill( results, results + mNumSamplers, Y() );
+			return;
+		}
+		size_t slot = mHead + mNumSamples - size;
+		slot = slot >= mNumSamples ? slot - mNumSamples : slot;
+		std::vector<T, A> acc( getRow( slot ), getRow( slot ) + mNumSamplers, mSlab.get_allocator() );
+		for ( size_t r = 1; r < size; ++r ) {
+			slot = slot + 1 == mNumSamples ? 0 : slot + 1;
+			switch ( reduction ) {
+			case REDUCE_MAX:
+				reduce::maximumInto( acc.data(), getRow( slot ), mNumSamplers );
+				break;
+			case REDUCE_MIN:
+				reduce::minimumInto( acc.data(), getRow( slot ), mNumSamplers );
+				break;
+			case REDUCE_MEAN:
+			case REDUCE_SUM:
+				reduce::addInto( acc.data(), getRow( slot ), mNumSamplers );
+				break;
+			}
+		}
+		for ( size_t i = 0; i < mNumSamplers; ++i ) {
+			results[ i ] = reduction == REDUCE_MEAN ? (Y)acc[ i ] / (Y)size : (Y)acc[ i ];
+		}
+	}
+
+	// Never called: setProcess( index, Reduction ) needs T convertible to Y
+	inline void reduceAll( Reduction, Y*, std::false_type ) const
+	{
+	}
+
+	inline const Process& resolveProcess( size_t index ) const
+	{
+		const Process* func = mProcessMap.get( index );
+		if ( func == nullptr ) {
+			SAMPLING_THROW( ExcProcNotFound( index ) );
+		}
+		if ( *func == nullptr ) {
+			SAMPLING_THROW( ExcProcUndefined( index ) );
+		}
+		return *func;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+enum Decimation
+{
+	DECIMATE_MAX, DECIMATE_MEAN, DECIMATE_MIN
+};
+
+/*
+ * A hierarchy of sampler windows at decreasing resolution. Tier 0 keeps
+ * the samples as they arrive; every factor samples that reach tier i are
+ * reduced to one (their mean, minimum or maximum, or a custom reducer)
+ * and pushed into tier i + 1. Each tier holds getNumSamples() values, so
+ * tier i spans getNumSamples() * factor^i input samples while costing no
+ * more memory or scan time than tier 0. Long-range queries go to
+ * getTier( findTier( span ) ), e.g. a minute of 1 kHz data with
+ *
+ *	TieredSamplerT<float, float> history( 1000, 10, 3 );		// 1 s, 10 s, 100 s
+ *	history.process( ID_PEAK, []( const WindowT<const float>& window )
+ *	{
+ *		return reduce::maximum( window );
+ *	} );
+ *	history.getTier( history.findTier( 60000 ) ).runProcess( ID_PEAK );
+ *
+ * Decimation sees every sample pushed, including those a block append()
+ * is too long for tier 0 to keep.
+ */
+template<typename T, typename Y, typename S = RingStorageT<T> >
+class TieredSamplerT
+{
+public:
+	typedef SamplerT<T, Y, S>							Tier;
+	typedef InplaceFunctionT<T( const T*, size_t )>		Reducer;
+
+	TieredSamplerT( size_t numSamples, size_t factor, size_t numTiers, Decimation decimation = DECIMATE_MEAN )
+		: mFactor( factor < 2 ? 2 : factor ), mTiers( numTiers < 1 ? 1 : numTiers )
+	{
+		mPending.resize( mTiers.size() );
+		mReduced.resize( mTiers.size() );
+		for ( Tier& tier : mTiers ) {
+			tier.setNumSamples( numSamples );
+		}
+		setDecimation( decimation );
+	}
+
+	template<typename F>
+	inline TieredSamplerT& process( size_t index, const F& func )
+	{
+		for ( Tier& tier : mTiers ) {
+			tier.process( index, func );
+		}
+		return *this;
+	}
+
+	inline void setDecimation( Decimation decimation )
+	{
+		switch ( decimation ) {
+		case DECIMATE_MAX:
+			mReducer = []( const T* data, size_t count )
+			{
+				return reduce::maximum( data, count );
+			};
+			break;
+		case DECIMATE_MEAN:
+			mReducer = []( const T* data, size_t count )
+			{
+				return reduce::sum( data, count ) / (T)count;
+			};
+			break;
+		case DECIMATE_MIN:
+			mReducer = []( const T* data, size_t count )
+			{
+				return reduce::minimum( data, count );
+			};
+			break;
+		}
+	}
+
+	// reducer is called as T( const T* block, size_t factor )
+	template<typename F>
+	inline void setReducer( F&& reducer )
+	{
+		mReducer = Reducer( std::forward<F>( reducer ) );
+	}
+
+	inline size_t getFactor() const
+	{
+		return mFactor;
+	}
+
+	inline size_t getNumSamples() const
+	{
+		return mTiers[ 0 ].getNumSamples();
+	}
+
+	inline size_t getNumTiers() const
+	{
+		return mTiers.size();
+	}
+
+	inline Tier& getTier( size_t tier )
+	{
+		return mTiers[ tier ];
+	}
+
+	inline const Tier& getTier( size_t tier ) const
+	{
+		return mTiers[ tier ];
+	}
+
+	// The finest tier whose window spans numSamples input samples, or the coarsest
+	inline size_t findTier( size_t numSamples ) const
+	{
+		size_t span = getNumSamples();
+		for ( size_t i = 0; i + 1 < mTiers.size(); ++i, span *= mFactor ) {
+			if ( span >= numSamples ) {
+				return i;
+			}
+		}
+		return mTiers.size() - 1;
+	}
+
+	inline void clearSamples()
+	{
+		for ( size_t i = 0; i < mTiers.size(); ++i ) {
+			mTiers[ i ].clearSamples();
+			mPending[ i ].clear();
+		}
+	}
+
+	inline void pushBack( const T& v )
+	{
+		mTiers[ 0 ].pushBack( v );
+		decimate( 0, &v, 1 );
+	}
+
+	inline void append( const T* data, size_t count )
+	{
+		mTiers[ 0 ].append( data, count );
+		decimate( 0, data, count );
+	}
+protected:
+	size_t							mFactor;
+	std::vector<std::vector<T> >	mPending;
+	std::vector<std::vector<T> >	mReduced;
+	Reducer							mReducer;
+	std::vector<Tier>				mTiers;
+
+	// Reduces samples that reached tier into blocks for the next tier up
+	inline void decimate( size_t tier, const T* data, size_t count )
+	{
+		if ( tier + 1 >= mTiers.size() ) {
+			return;
+		}
+		std::vector<T>& pending	= mPending[ tier ];
+		std::vector<T>& reduced	= mReduced[ tier ];
+		reduced.clear();
+		size_t i = 0;
+		while ( i < count ) {
+			if ( pending.empty() && count - i >= mFactor ) {
+				reduced.push_back( mReducer( data + i, mFactor ) );
+				i += mFactor;
+				continue;
+			}
+			size_t n = mFactor - pending.size() < count - i ? mFactor - pending.size() : count - i;
+			pending.insert( pending.end(), data + i, data + i + n );
+			i += n;
+			if ( pending.size() == mFactor ) {
+				reduced.push_back( mReducer( pending.data(), mFactor ) );
+				pending.clear();
+			}
+		}
+		if ( !reduced.empty() ) {
+			mTiers[ tier + 1 ].append( reduced.data(), reduced.size() );
+			decimate( tier + 1, reduced.data(), reduced.size() );
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A window bounded by time instead of count: every sample carries a
+ * timestamp, and samples older than getDuration() relative to the newest
+ * (or to the time given to expire()) are evicted from the front. Each
+ * sample is evicted once, so eviction is amortized O(1), and accumulators
+ * see the evictions as pops just as they would on a count-limited window.
+ * maxSamples caps the window by count as well; size it for the highest
+ * rate the feed can reach in getDuration(). Timestamps must not decrease.
+ *
+ *	TimedSamplerT<float, float> recent( std::chrono::milliseconds( 500 ), 4096 );
+ *	recent.accumulate( ID_MEAN, RunningMeanT<float, float>() );
+ *	recent.pushBack( v );		// stamped with steady_clock::now()
+ */
+template<typename T, typename Y, typename S = RingStorageT<T>, typename C = std::chrono::steady_clock>
+class TimedSamplerT
+{
+public:
+	typedef C							Clock;
+	typedef typename C::duration		Duration;
+	typedef typename C::time_point		TimePoint;
+	typedef SamplerT<T, Y, S>			Sampler;
+
+	TimedSamplerT( Duration duration, size_t maxSamples )
+		: mDuration( duration ), mSampler( maxSamples )
+	{
+		mSampler.setPadded( false );
+	}
+
+	template<typename A>
+	inline TimedSamplerT& accumulate( size_t index, const A& accumulator )
+	{
+		mSampler.accumulate( index, accumulator );
+		return *this;
+	}
+
+	template<typename K>
+	inline TimedSamplerT& kernel( size_t index, const K& kernel )
+	{
+		mSampler.kernel( index, kernel );
+		return *this;
+	}
+
+	template<typename F>
+	inline TimedSamplerT& process( size_t index, F&& func )
+	{
+		mSampler.process( index, std::forward<F>( func ) );
+		return *this;
+	}
+
+	inline Y runProcess( size_t index )
+	{
+		return mSampler.runProcess( index );
+	}
+
+	inline Duration getDuration() const
+	{
+		return mDuration;
+	}
+
+	// Takes effect at the next pushBack() or expire()
+	inline void setDuration( Duration duration )
+	{
+		mDuration = duration;
+	}
+
+	inline Sampler& getSampler()
+	{
+		return mSampler;
+	}
+
+	inline const Sampler& getSampler() const
+	{
+		return mSampler;
+	}
+
+	inline size_t getSize() const
+	{
+		return mTimes.size();
+	}
+
+	// Timestamp of sample index, oldest first
+	inline TimePoint getTime( size_t index ) const
+	{
+		return mTimes[ index ];
+	}
+
+	inline WindowT<const T> getWindow() const
+	{
+		return mSampler.getWindow();
+	}
+
+	inline void clearSamples()
+	{
+		mSampler.clearSamples();
+		mTimes.clear();
+	}
+
+	// Evicts every sample more than getDuration() older than now
+	inline void expire( TimePoint now = Clock::now() )
+	{
+		size_t count = 0;
+		while ( count < mTimes.size() && now - mTimes[ count ] > mDuration ) {
+			++count;
+		}
+		if ( count > 0 ) {
+			mSampler.popFront( count );
+			mTimes.erase( mTimes.begin(), mTimes.begin() + count );
+		}
+	}
+
+	inline void pushBack( const T& v, TimePoint time = Clock::now() )
+	{
+		mSampler.pushBack( v );
+		mTimes.push_back( time );
+		// The count cap may have evicted the oldest sample
+		if ( mTimes.size() > mSampler.getWindow().size() ) {
+			mTimes.pop_front();
+		}
+		expire( time );
+	}
+protected:
+	Duration				mDuration;
+	Sampler					mSampler;
+	std::deque<TimePoint>	mTimes;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A sampler window that one thread writes while any number of threads read
+ * it. pushBack() and append() are wait-free and must only be called from a
+ * single producer thread. Readers never block the producer: snapshot()
+ * copies the newest getNumSamples() values out seqlock-style and retries if
+ * the producer lapped the copy. Readers then run their processes on their
+ * own SamplerT, e.g.
+ *
+ *	feed.pushBack( v );				// capture thread
+ *	feed.snapshot( view );			// render thread
+ *	view.runProcess( ID_MEAN );
+ *
+ * The ring holds at least twice the window so a reader has a full window's
+ * worth of pushes of slack before it has to retry. T must be trivially
+ * copyable, since readers may copy a slot while it is being overwritten
+ * and discard the result.
+ */
+template<typename T>
+class ConcurrentSamplerT
+{
+	static_assert( std::is_trivially_copyable<T>::value, "ConcurrentSamplerT requires a trivially copyable sample type" );
+public:
+	ConcurrentSamplerT( size_t numSamples = 2 )
+		: mNumSamples( numSamples < 1 ? 1 : numSamples ), mStarted( 0 ), mWritten( 0 )
+	{
+		size_t capacity = 1;
+		while ( capacity < mNumSamples * 2 ) {
+			capacity <<= 1;
+		}
+		mBuffer.resize( capacity );
+		mMask = capacity - 1;
+	}
+
+	inline size_t getCapacity() const
+	{
+		return mBuffer.size();
+	}
+
+	inline size_t getNumPushed() const
+	{
+		return mWritten.load( std::memory_order_acquire );
+	}
+
+	inline size_t getNumSamples() const
+	{
+		return mNumSamples;
+	}
+
+	// Producer thread only
+	inline void pushBack( const T& v )
+	{
+		size_t n = mWritten.load( std::memory_order_relaxed );
+		mStarted.store( n + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		mBuffer[ n & mMask ] = v;
+		mWritten.store( n + 1, std::memory_order_release );
+	}
+
+	/*
+	 * Producer thread only. Publishes the whole block at once. Every sample
+	 * counts towards getNumPushed(), but only the newest getNumSamples() of
+	 * a longer block are copied, since the rest would never be read.
+	 */
+	inline void append( const T* data, size_t count )
+	{
+		size_t written = mWritten.load( std::memory_order_relaxed ) + count;
+		if ( count > mNumSamples ) {
+			data	+= count - mNumSamples;
+			count	= mNumSamples;
+		}
+		mStarted.store( written, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		size_t tail		= ( written - count ) & mMask;
+		size_t first	= count < mBuffer.size() - tail ? count : mBuffer.size() - tail;
+		std::copy( data, data + first, mBuffer.begin() + tail );
+		std::copy( data + first, data + count, mBuffer.begin() );
+		mWritten.store( written, std::memory_order_release );
+	}
+
+	/*
+	 * Copies the newest samples, oldest first, into out and returns the
+	 * push count the copy corresponds to. Fewer than getNumSamples() values
+	 * are returned until the producer has filled the window.
+	 */
+	inline size_t snapshot( std::vector<T>& out ) const
+	{
+		for ( ;; ) {
+			size_t written	= mWritten.load( std::memory_order_acquire );
+			size_t count	= written < mNumSamples ? written : mNumSamples;
+			size_t head		= ( written - count ) & mMask;
+			size_t first	= count < mBuffer.size() - head ? count : mBuffer.size() - head;
+			out.resize( count );
+			std::copy( mBuffer.begin() + head, mBuffer.begin() + head + first, out.begin() );
+			std::copy( mBuffer.begin(), mBuffer.begin() + ( count - first ), out.begin() + first );
+			if ( isIntact( written - count ) ) {
+				return written;
+			}
+		}
+	}
+
+	/*
+	 * Replaces the samples in sampler with the current window. The copy is
+	 * taken, and retried if torn, into scratch first, so the sampler is
+	 * resized to getNumSamples() and appended to once: its triggers,
+	 * accumulators and counters only ever see an intact copy.
+	 */
+	template<typename Y, typename S, typename I>
+	inline size_t snapshot( SamplerT<T, Y, S, I>& sampler, std::vector<T>& scratch ) const
+	{
+		size_t written = snapshot( scratch );
+		sampler.clearSamples();
+		sampler.setNumSamples( mNumSamples );
+		sampler.append( scratch.data(), scratch.size() );
+		return written;
+	}
+
+	template<typename Y, typename S, typename I>
+	inline size_t snapshot( SamplerT<T, Y, S, I>& sampler ) const
+	{
+		std::vector<T> scratch;
+		return snapshot( sampler, scratch );
+	}
+protected:
+	std::vector<T>		mBuffer;
+	size_t				mMask;
+	size_t				mNumSamples;
+	std::atomic<size_t>	mStarted;
+	std::atomic<size_t>	mWritten;
+
+	// True if no push that began during the copy can have touched push
+	// index oldest or later
+	inline bool isIntact( size_t oldest ) const
+	{
+		std::atomic_thread_fence( std::memory_order_acquire );
+		return mStarted.load( std::memory_order_relaxed ) <= oldest + mBuffer.size();
 	}
 };
 
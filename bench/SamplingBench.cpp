@@ -0,0 +1,372 @@
+/*
+ * Benchmarks for the SamplerT hot paths. Run with
+ *
+ *	sampling_bench --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * or build the sampling_bench_json target, which writes sampling_bench.json.
+ */
+
+#include "Sampling.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace sampling;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Pushes a full window of samples
+template<typename Sampler>
+static void fill( Sampler& sampler )
+{
+	for ( size_t i = 0; i < sampler.getNumSamples(); ++i ) {
+		sampler.pushBack( (float)i );
+	}
+}
+
+// Ingestion: one push per iteration into a full window of range( 0 ) samples
+template<typename Sampler>
+static void BM_PushBack( benchmark::State& state )
+{
+	Sampler sampler( (size_t)state.range( 0 ) );
+	fill( sampler );
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		sampler.pushBack( v += 1.0f );
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK_TEMPLATE( BM_PushBack, SamplerT<float, float> )->RangeMultiplier( 16 )->Range( 16, 65536 );
+BENCHMARK_TEMPLATE( BM_PushBack, RingSamplerT<float, float> )->RangeMultiplier( 16 )->Range( 16, 65536 );
+BENCHMARK_TEMPLATE( BM_PushBack, FixedSamplerT<float, float, 4096> )->Arg( 4096 );
+
+// Ingestion with running statistics kept up to date on every push
+static void BM_PushBackAccumulators( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	sampler.accumulate( 0, RunningMeanT<float, float>() );
+	sampler.accumulate( 1, RunningVarianceT<float, float>() );
+	sampler.accumulate( 2, SlidingMaxT<float, float>() );
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		sampler.pushBack( v += 1.0f );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_PushBackAccumulators )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+// Ingestion with a threshold trigger on a running mean, checked every range( 0 ) samples
+static void BM_PushBackTrigger( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( 1024 );
+	sampler.accumulate( 0, RunningMeanT<float, float>() );
+	size_t fired = 0;
+	sampler.trigger( 0, TRIGGER_CROSSING, 512.0f, [ &fired ]( const TriggerEventT<float>& )
+	{
+		++fired;
+	} );
+	sampler.setTriggerInterval( (size_t)state.range( 0 ) );
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		v = v < 1024.0f ? v + 1.0f : 0.0f;
+		sampler.pushBack( v );
+	}
+	benchmark::DoNotOptimize( fired );
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_PushBackTrigger )->Arg( 1 )->Arg( 64 );
+
+// Block ingestion, 256 samples per append
+template<typename Sampler>
+static void BM_Append( benchmark::State& state )
+{
+	Sampler sampler( (size_t)state.range( 0 ) );
+	std::vector<float> block( 256, 1.0f );
+	for ( auto _ : state ) {
+		sampler.append( block.data(), block.size() );
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed( state.iterations() * block.size() );
+}
+BENCHMARK_TEMPLATE( BM_Append, SamplerT<float, float> )->RangeMultiplier( 16 )->Range( 256, 65536 );
+BENCHMARK_TEMPLATE( BM_Append, RingSamplerT<float, float> )->RangeMultiplier( 16 )->Range( 256, 65536 );
+
+// Resizing the window, which evicts or pads through fit()
+static void BM_SetNumSamples( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	size_t sizes[] = { (size_t)state.range( 0 ), (size_t)state.range( 0 ) / 2 };
+	size_t i = 0;
+	for ( auto _ : state ) {
+		sampler.setNumSamples( sizes[ i ^= 1 ] );
+	}
+}
+BENCHMARK( BM_SetNumSamples )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename Sampler>
+static void addProcesses( Sampler& sampler, size_t count )
+{
+	for ( size_t i = 0; i < count; ++i ) {
+		float scale = (float)( i + 1 );
+		sampler.process( i, [ scale ]( const WindowT<const float>& window )
+		{
+			return window.back() * scale;
+		} );
+	}
+}
+
+// Dispatch: one runProcess() among range( 0 ) registered processes
+static void BM_RunProcess( benchmark::State& state )
+{
+	SamplerT<float, float> sampler( 1024 );
+	addProcesses( sampler, (size_t)state.range( 0 ) );
+	fill( sampler );
+	size_t index = 0;
+	for ( auto _ : state ) {
+		benchmark::DoNotOptimize( sampler.runProcess( index ) );
+		index = index + 1 == (size_t)state.range( 0 ) ? 0 : index + 1;
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_RunProcess )->Arg( 1 )->Arg( 10 )->Arg( 100 );
+
+static void BM_TryRunProcess( benchmark::State& state )
+{
+	SamplerT<float, float> sampler( 1024 );
+	addProcesses( sampler, (size_t)state.range( 0 ) );
+	fill( sampler );
+	size_t index = 0;
+	float result = 0.0f;
+	for ( auto _ : state ) {
+		benchmark::DoNotOptimize( sampler.tryRunProcess( index, result ) );
+		index = index + 1 == (size_t)state.range( 0 ) ? 0 : index + 1;
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_TryRunProcess )->Arg( 1 )->Arg( 10 )->Arg( 100 );
+
+// Every registered process in one call
+static void BM_RunAll( benchmark::State& state )
+{
+	SamplerT<float, float> sampler( 1024 );
+	addProcesses( sampler, (size_t)state.range( 0 ) );
+	fill( sampler );
+	std::vector<float> results;
+	for ( auto _ : state ) {
+		sampler.runAll( results );
+		benchmark::DoNotOptimize( results.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_RunAll )->Arg( 1 )->Arg( 10 )->Arg( 100 );
+
+// Four kernels fused into one pass over a range( 0 ) window
+static void BM_RunAllKernels( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	sampler.kernel( 0, SumKernelT<float, float>() );
+	sampler.kernel( 1, MinKernelT<float, float>() );
+	sampler.kernel( 2, MaxKernelT<float, float>() );
+	sampler.kernel( 3, RmsKernelT<float, float>() );
+	fill( sampler );
+	std::vector<float> results;
+	for ( auto _ : state ) {
+		sampler.runAll( results );
+		benchmark::DoNotOptimize( results.data() );
+	}
+	state.SetBytesProcessed( state.iterations() * state.range( 0 ) * sizeof( float ) );
+}
+BENCHMARK( BM_RunAllKernels )->RangeMultiplier( 16 )->Range( 256, 65536 );
+
+// Repeated queries between pushes served from the results cache
+static void BM_RunProcessCached( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( 4096 );
+	sampler.kernel( 0, SumKernelT<float, float>() );
+	sampler.setCaching( state.range( 0 ) != 0 );
+	fill( sampler );
+	for ( auto _ : state ) {
+		benchmark::DoNotOptimize( sampler.runProcess( 0 ) );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_RunProcessCached )->Arg( 0 )->Arg( 1 );
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copying a sampler with a range( 0 ) window and ten processes
+static void BM_Copy( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	addProcesses( sampler, 10 );
+	fill( sampler );
+	for ( auto _ : state ) {
+		RingSamplerT<float, float> copy( sampler );
+		benchmark::DoNotOptimize( &copy );
+	}
+}
+BENCHMARK( BM_Copy )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+static void BM_Move( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	addProcesses( sampler, 10 );
+	fill( sampler );
+	for ( auto _ : state ) {
+		RingSamplerT<float, float> moved( std::move( sampler ) );
+		sampler = std::move( moved );
+		benchmark::DoNotOptimize( &sampler );
+	}
+}
+BENCHMARK( BM_Move )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+// A push then a snapshot released before the next push, so nothing is copied
+static void BM_Snapshot( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		sampler.pushBack( v += 1.0f );
+		benchmark::DoNotOptimize( sampler.snapshot().size() );
+	}
+}
+BENCHMARK( BM_Snapshot )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+// A snapshot held across the next push, which then detaches with one copy of the window
+static void BM_SnapshotHeld( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( (size_t)state.range( 0 ) );
+	RingSamplerT<float, float>::Snapshot snapshot;
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		sampler.pushBack( v += 1.0f );
+		snapshot = sampler.snapshot();
+		benchmark::DoNotOptimize( snapshot.size() );
+	}
+}
+BENCHMARK( BM_SnapshotHeld )->RangeMultiplier( 16 )->Range( 16, 65536 );
+
+// One push per export; arg 1 streams deltas, arg 0 exports the full window
+static void BM_ExportWindow( benchmark::State& state )
+{
+	RingSamplerT<float, float> sampler( 4096 );
+	fill( sampler );
+	std::vector<unsigned char> buffer( sizeof( ExportHeader ) + 4096 * sizeof( float ) );
+	ExportCursor cursor;
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		sampler.pushBack( v += 1.0f );
+		RingSamplerT<float, float>::WindowExport frame = state.range( 0 ) != 0 ? sampler.exportWindow( cursor ) : sampler.exportWindow();
+		frame.copyTo( buffer.data() );
+		benchmark::DoNotOptimize( buffer.data() );
+	}
+}
+BENCHMARK( BM_ExportWindow )->Arg( 0 )->Arg( 1 );
+
+// One tick of 10k metrics: separate samplers against one bank
+static void BM_PushBackSamplers( benchmark::State& state )
+{
+	std::vector<SamplerT<float, float> > samplers( 10000, SamplerT<float, float>( 60 ) );
+	std::vector<float> values( samplers.size(), 1.0f );
+	for ( auto _ : state ) {
+		for ( size_t i = 0; i < samplers.size(); ++i ) {
+			samplers[ i ].pushBack( values[ i ] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * samplers.size() );
+}
+BENCHMARK( BM_PushBackSamplers );
+
+static void BM_PushBackBank( benchmark::State& state )
+{
+	SamplerBankT<float, float> bank( 10000, 60 );
+	std::vector<float> values( bank.getNumSamplers(), 1.0f );
+	for ( auto _ : state ) {
+		bank.pushBackAll( values.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * bank.getNumSamplers() );
+}
+BENCHMARK( BM_PushBackBank );
+
+static void BM_RunProcessAll( benchmark::State& state )
+{
+	SamplerBankT<float, float> bank( 10000, 60 );
+	bank.process( 0, []( const WindowT<const float>& window )
+	{
+		return reduce::sum( window );
+	} );
+	std::vector<float> values( bank.getNumSamplers(), 1.0f );
+	std::vector<float> results( bank.getNumSamplers() );
+	bank.pushBackAll( values.data() );
+	for ( auto _ : state ) {
+		bank.runProcessAll( 0, results.data() );
+		benchmark::DoNotOptimize( results.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * bank.getNumSamplers() );
+}
+BENCHMARK( BM_RunProcessAll );
+
+// The same sums as a Reduction, folded row by row with SIMD across samplers
+static void BM_ReduceAll( benchmark::State& state )
+{
+	SamplerBankT<float, float> bank( 10000, 60 );
+	bank.process( 0, REDUCE_SUM );
+	std::vector<float> values( bank.getNumSamplers(), 1.0f );
+	std::vector<float> results( bank.getNumSamplers() );
+	bank.pushBackAll( values.data() );
+	for ( auto _ : state ) {
+		bank.runProcessAll( 0, results.data() );
+		benchmark::DoNotOptimize( results.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * bank.getNumSamplers() );
+}
+BENCHMARK( BM_ReduceAll );
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Concurrent access: thread 0 pushes while every other thread takes snapshots
+static ConcurrentSamplerT<float> sFeed( 4096 );
+
+static void BM_Concurrent( benchmark::State& state )
+{
+	std::vector<float> view;
+	float v = 0.0f;
+	for ( auto _ : state ) {
+		if ( state.thread_index() == 0 ) {
+			sFeed.pushBack( v += 1.0f );
+		} else {
+			benchmark::DoNotOptimize( sFeed.snapshot( view ) );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_Concurrent )->Threads( 2 )->Threads( 4 )->UseRealTime();
+
+// Independent processes spread over a thread pool
+static void BM_RunProcessesParallel( benchmark::State& state )
+{
+	ThreadPool pool( 4 );
+	RingSamplerT<float, float> sampler( 65536 );
+	std::vector<size_t> indices;
+	for ( size_t i = 0; i < 8; ++i ) {
+		sampler.process( i, []( const WindowT<const float>& window )
+		{
+			return reduce::sum( window );
+		} );
+		indices.push_back( i );
+	}
+	fill( sampler );
+	if ( state.range( 0 ) != 0 ) {
+		sampler.setExecutor( pool.getExecutor() );
+	}
+	std::vector<float> results;
+	for ( auto _ : state ) {
+		sampler.runProcessesParallel( indices, results );
+		benchmark::DoNotOptimize( results.data() );
+	}
+}
+BENCHMARK( BM_RunProcessesParallel )->Arg( 0 )->Arg( 1 )->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+/*
+ * Running accumulators against statistics recomputed from the window.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_MAX, ID_MEAN, ID_MEDIAN, ID_MIN, ID_SUM, ID_VARIANCE };
+
+/*
+ * Running accumulators, kept up to date through pushes, edits, resizes and
+ * a copy, against the same statistics recomputed from the window.
+ */
+template<typename Sampler>
+static void testAccumulators()
+{
+	Sampler sampler( 16 );
+	sampler.accumulate( ID_MAX, SlidingMaxT<double>() );
+	sampler.accumulate( ID_MEAN, RunningMeanT<double>() );
+	sampler.accumulate( ID_MEDIAN, SlidingQuantileT<double>( 0.5, 0.0, 100.0, 100 ) );
+	sampler.accumulate( ID_MIN, SlidingMinT<double>() );
+	sampler.accumulate( ID_SUM, RunningSumT<double>() );
+	sampler.accumulate( ID_VARIANCE, RunningVarianceT<double>() );
+	std::mt19937 rng( 11 );
+	for ( int i = 0; i < 1000; ++i ) {
+		// Whole numbers, so each lands in its own quantile bin
+		double v = (double)( rng() % 100 );
+		if ( i % 37 == 0 ) {
+			sampler.insertSample( std::min<size_t>( 3, sampler.getWindow().size() ), v );
+		} else if ( i % 53 == 0 ) {
+			sampler.eraseSample( 5 );
+		} else if ( i % 101 == 0 ) {
+			sampler.setNumSamples( 8 + rng() % 20 );
+		} else {
+			sampler.pushBack( v );
+		}
+		if ( i == 500 ) {
+			Sampler copy( sampler );
+			sampler = copy;
+		}
+
+		std::vector<double> window( sampler.getWindow().begin(), sampler.getWindow().end() );
+		double sum = 0.0;
+		for ( double x : window ) {
+			sum += x;
+		}
+		double mean		= sum / window.size();
+		double variance	= 0.0;
+		for ( double x : window ) {
+			variance += ( x - mean ) * ( x - mean );
+		}
+		variance /= window.size();
+		std::sort( window.begin(), window.end() );
+		double median = window[ (size_t)( 0.5 * ( window.size() - 1 ) ) ];
+
+		CHECK( sampler.runProcess( ID_MAX ) == window.back() );
+		CHECK( std::fabs( sampler.runProcess( ID_MEAN ) - mean ) < 1e-9 );
+		CHECK( std::floor( sampler.runProcess( ID_MEDIAN ) ) == median );
+		CHECK( sampler.runProcess( ID_MIN ) == window.front() );
+		CHECK( std::fabs( sampler.runProcess( ID_SUM ) - sum ) < 1e-9 );
+		CHECK( std::fabs( sampler.runProcess( ID_VARIANCE ) - variance ) < 1e-6 );
+	}
+	sampler.clearSamples();
+	CHECK( sampler.runProcess( ID_SUM ) == 0.0 );
+}
+
+static void testAccumulatorResults()
+{
+	testAccumulators<SamplerT<double, double> >();
+	testAccumulators<RingSamplerT<double, double> >();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testAccumulatorResults();
+	return report();
+}
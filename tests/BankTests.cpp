@@ -0,0 +1,140 @@
+/*
+ * SamplerBankT against one SamplerT per sampler: windows, general
+ * processes and the SIMD reductions, padded and unpadded, across wraps.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_FRONT, ID_MAX, ID_MEAN, ID_MIN, ID_MISSING, ID_SUM };
+
+/*
+ * A sampler count that is not a multiple of any SIMD width, so the
+ * reductions run their scalar tails too.
+ */
+static void testBank()
+{
+	typedef SamplerBankT<float, float> Bank;
+	typedef SamplerT<float, float> Sampler;
+	const size_t numSamplers = 37, numSamples = 7;
+	Bank bank( numSamplers, numSamples );
+	bank.process( ID_FRONT, []( const Bank::Window& window ) { return window.empty() ? -1.0f : window.front(); } );
+	bank.process( ID_MAX, REDUCE_MAX );
+	bank.process( ID_MEAN, REDUCE_MEAN );
+	bank.process( ID_MIN, REDUCE_MIN );
+	bank.process( ID_SUM, REDUCE_SUM );
+	std::vector<Sampler> padded( numSamplers, Sampler( numSamples ) );
+	std::vector<Sampler> unpadded( numSamplers, Sampler( numSamples ) );
+	for ( Sampler& sampler : unpadded ) {
+		sampler.setPadded( false );
+	}
+
+	std::mt19937 rng( 5 );
+	std::vector<float> values( numSamplers ), results;
+	for ( int t = 0; t < 25; ++t ) {
+		// Small whole numbers, so sums come out exact in any order
+		for ( float& v : values ) {
+			v = (float)( rng() % 64 ) - 32.0f;
+		}
+		bank.pushBackAll( values );
+		for ( size_t i = 0; i < numSamplers; ++i ) {
+			padded[ i ].pushBack( values[ i ] );
+			unpadded[ i ].pushBack( values[ i ] );
+		}
+		for ( int pad = 0; pad < 2; ++pad ) {
+			bank.setPadded( pad == 0 );
+			const std::vector<Sampler>& model = pad == 0 ? padded : unpadded;
+			CHECK( bank.getSize() == model[ 0 ].getWindow().size() );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( matches( bank.getWindow( i ), model[ i ].getWindow() ) );
+			}
+			bank.runProcessAll( ID_FRONT, results );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( results[ i ] == model[ i ].getWindow().front() );
+			}
+			bank.runProcessAll( ID_SUM, results );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( results[ i ] == reduce::sum( model[ i ].getWindow() ) );
+			}
+			bank.runProcessAll( ID_MEAN, results );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( results[ i ] == reduce::sum( model[ i ].getWindow() ) / (float)bank.getSize() );
+			}
+			bank.runProcessAll( ID_MAX, results );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( results[ i ] == reduce::maximum( model[ i ].getWindow() ) );
+			}
+			bank.runProcessAll( ID_MIN, results );
+			for ( size_t i = 0; i < numSamplers; ++i ) {
+				CHECK( results[ i ] == reduce::minimum( model[ i ].getWindow() ) );
+			}
+
+			// One sampler at a time gives the same results
+			CHECK( bank.runProcess( ID_MAX, 3 ) == reduce::maximum( model[ 3 ].getWindow() ) );
+			CHECK( bank.runProcess( ID_FRONT, 36 ) == model[ 36 ].getWindow().front() );
+		}
+	}
+	CHECK( bank.getNumValidSamples() == numSamples );
+
+	// Replacing a reduction with a plain process takes it off the SIMD path
+	bank.process( ID_SUM, []( const Bank::Window& window ) { return (float)window.size(); } );
+	bank.runProcessAll( ID_SUM, results );
+	CHECK( results[ 0 ] == (float)numSamples );
+
+	bank.clearSamples();
+	bank.setPadded( false );
+	CHECK( bank.getWindow( 5 ).empty() );
+	bank.runProcessAll( ID_FRONT, results );
+	CHECK( results[ 0 ] == -1.0f );
+	bank.runProcessAll( ID_MEAN, results );
+	CHECK( results[ 0 ] == 0.0f );
+}
+
+// Pushing writes one contiguous row of the slab
+static void testLayout()
+{
+	SamplerBankT<int, int> bank( 4, 3 );
+	int row[] = { 1, 2, 3, 4 };
+	bank.pushBackAll( row );
+	CHECK( bank.getHead() == 1 );
+	CHECK( std::equal( row, row + 4, bank.getSlab() ) );
+	bank.pushBackAll( row );
+	bank.pushBackAll( row );
+	CHECK( bank.getHead() == 0 );
+}
+
+static void testErrors()
+{
+	SamplerBankT<float, float> bank( 4, 3 );
+	bank.process( ID_FRONT, nullptr );
+	std::vector<float> results;
+#if defined( SAMPLING_EXCEPTIONS )
+	bool threw = false;
+	try {
+		bank.runProcessAll( ID_MISSING, results );
+	} catch ( const ExcProcNotFound& ) {
+		threw = true;
+	}
+	CHECK( threw );
+	threw = false;
+	try {
+		bank.runProcess( ID_FRONT, 0 );
+	} catch ( const ExcProcUndefined& ) {
+		threw = true;
+	}
+	CHECK( threw );
+#endif
+	bank.eraseProcess( ID_FRONT );
+	CHECK( bank.getProcessMap().size() == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testBank();
+	testLayout();
+	testErrors();
+	return report();
+}
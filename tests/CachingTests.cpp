@@ -0,0 +1,125 @@
+/*
+ * Result caching: repeated queries between changes are free, and every
+ * change to the samples makes each process run exactly once more.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_ACCUMULATED, ID_KERNEL, ID_SUM };
+
+typedef SamplerT<float, float> Sampler;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every kind of change, each followed by repeated single, batch and parallel queries
+static void testCaching()
+{
+	Sampler sampler( 6 );
+	Sampler reference( 6 );
+	int numRuns = 0;
+	sampler.process( ID_SUM, [ &numRuns ]( const Sampler::Window& window ) { ++numRuns; return reduce::sum( window ); } );
+	sampler.kernel( ID_KERNEL, SumKernelT<float, float>() );
+	sampler.accumulate( ID_ACCUMULATED, RunningSumT<float, float>() );
+	sampler.setCaching( true );
+	CHECK( sampler.isCaching() );
+	reference.process( ID_SUM, []( const Sampler::Window& window ) { return reduce::sum( window ); } );
+
+	ThreadPool pool( 2 );
+	sampler.setExecutor( pool.getExecutor() );
+	const std::vector<size_t> ids = { ID_ACCUMULATED, ID_KERNEL, ID_SUM };
+	std::vector<float> results;
+	std::mt19937 rng( 12 );
+	for ( int i = 0; i < 300; ++i ) {
+		uint64_t generation = sampler.getGeneration();
+		float v = (float)( rng() % 50 );
+		switch ( i % 10 ) {
+		case 0: {
+			size_t index = std::min<size_t>( 1, sampler.getWindow().size() );
+			sampler.insertSample( index, v );
+			reference.insertSample( index, v );
+			break;
+		}
+		case 1:
+			sampler.eraseSample( 2 );
+			reference.eraseSample( 2 );
+			break;
+		case 2: {
+			float block[] = { v, v + 1.0f, v + 2.0f };
+			sampler.append( block, 3 );
+			reference.append( block, 3 );
+			break;
+		}
+		case 3:
+			sampler.setNumSamples( sampler.getNumSamples() == 6 ? 4 + rng() % 2 : 6 + rng() % 3 );
+			reference.setNumSamples( sampler.getNumSamples() );
+			break;
+		case 4:
+			sampler.popFront( 2 );
+			reference.popFront( 2 );
+			break;
+		case 5:
+			sampler.getSamples().back() = v;
+			reference.getSamples().back() = v;
+			sampler.invalidate();
+			break;
+		case 6:
+			if ( i % 50 == 6 ) {
+				sampler.clearSamples();
+				reference.clearSamples();
+				break;
+			}
+			// Fall through
+		default:
+			sampler.pushBack( v );
+			reference.pushBack( v );
+			break;
+		}
+		CHECK( sampler.getGeneration() != generation );
+		generation = sampler.getGeneration();
+
+		float expected = reference.runProcess( ID_SUM );
+		int runs = numRuns;
+		CHECK( sampler.runProcess( ID_SUM ) == expected );
+		CHECK( sampler.runProcess( ID_SUM ) == expected );
+		sampler.runProcesses( ids, results );
+		CHECK( results[ 0 ] == expected && results[ 1 ] == expected && results[ 2 ] == expected );
+		sampler.runProcessesParallel( ids, results );
+		CHECK( results[ 0 ] == expected && results[ 1 ] == expected && results[ 2 ] == expected );
+		CHECK( numRuns == runs + 1 );
+		CHECK( sampler.getGeneration() == generation );
+	}
+}
+
+// Other windows bypass the cache; replacing a process or turning caching off drops its result
+static void testCacheScope()
+{
+	Sampler sampler( 4 );
+	int numRuns = 0;
+	sampler.process( ID_SUM, [ &numRuns ]( const Sampler::Window& window ) { ++numRuns; return reduce::sum( window ); } );
+	sampler.setCaching( true );
+	for ( int i = 1; i <= 4; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	CHECK( sampler.runProcess( ID_SUM ) == 10.0f && numRuns == 1 );
+	CHECK( sampler.runProcess( ID_SUM, sampler.tail( 2 ) ) == 7.0f && numRuns == 2 );
+	CHECK( sampler.runProcess( ID_SUM ) == 10.0f && numRuns == 2 );
+
+	Sampler copy( sampler );
+	CHECK( copy.isCaching() && copy.getGeneration() == sampler.getGeneration() );
+
+	sampler.process( ID_SUM, [ &numRuns ]( const Sampler::Window& ) { ++numRuns; return 42.0f; } );
+	CHECK( sampler.runProcess( ID_SUM ) == 42.0f && numRuns == 3 );
+	sampler.setCaching( false );
+	CHECK( sampler.runProcess( ID_SUM ) == 42.0f && sampler.runProcess( ID_SUM ) == 42.0f && numRuns == 5 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testCaching();
+	testCacheScope();
+	return report();
+}
@@ -0,0 +1,85 @@
+/*
+ * ConcurrentSamplerT: windows stay intact while the producer writes, and
+ * a snapshot lands in a SamplerT as one append however often it retried.
+ */
+
+#include "Testing.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace sampling;
+
+// Pushes and blocks from one thread, read back on the same thread
+static void testWindow()
+{
+	ConcurrentSamplerT<float> feed( 5 );
+	std::vector<float> view;
+	CHECK( feed.snapshot( view ) == 0 && view.empty() );
+	feed.pushBack( 1.0f );
+	feed.pushBack( 2.0f );
+	CHECK( feed.snapshot( view ) == 2 && view.size() == 2 && view[ 1 ] == 2.0f );
+
+	// Only the newest five of a longer block are kept, but all are counted
+	std::vector<float> block( 12 );
+	for ( size_t i = 0; i < block.size(); ++i ) {
+		block[ i ] = (float)( 10 + i );
+	}
+	feed.append( block.data(), block.size() );
+	CHECK( feed.getNumPushed() == 14 );
+	CHECK( feed.snapshot( view ) == 14 && view.size() == 5 && view.front() == 17.0f && view.back() == 21.0f );
+
+	SamplerT<float, float> sampler( 2 );
+	CHECK( feed.snapshot( sampler ) == 14 );
+	CHECK( sampler.getNumSamples() == 5 && matches( sampler.getWindow(), view ) );
+}
+
+/*
+ * Every window a reader copies while the producer runs is a run of
+ * consecutive pushes ending at the count returned, and a sampler fed by
+ * snapshot() ingests exactly one window per call.
+ */
+static void testProducer()
+{
+	typedef SamplerT<float, float, VectorStorageT<float>, Instrumentation> Sampler;
+	const size_t numSamples = 64, numPushes = 200000;
+	ConcurrentSamplerT<float> feed( numSamples );
+	std::atomic<bool> done( false );
+	std::thread producer( [ & ]()
+	{
+		for ( size_t i = 1; i <= numPushes; ++i ) {
+			feed.pushBack( (float)i );
+			if ( i % 1000 == 0 ) {
+				std::this_thread::yield();
+			}
+		}
+		done.store( true );
+	} );
+
+	Sampler sampler( numSamples );
+	std::vector<float> view, scratch;
+	size_t numIngested = 0;
+	bool intact = true;
+	while ( !done.load() ) {
+		size_t written = feed.snapshot( view );
+		for ( size_t i = 0; i < view.size(); ++i ) {
+			intact = intact && view[ i ] == (float)( written - view.size() + 1 + i );
+		}
+		written = feed.snapshot( sampler, scratch );
+		numIngested += written < numSamples ? written : numSamples;
+		intact = intact && sampler.getWindow().back() == ( written > 0 ? (float)written : 0.0f );
+	}
+	producer.join();
+	CHECK( intact );
+	CHECK( sampler.getStats().numIngested == numIngested );
+	CHECK( feed.getNumPushed() == numPushes );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testWindow();
+	testProducer();
+	return report();
+}
@@ -0,0 +1,114 @@
+/*
+ * Window export and import: full and delta frames, and rejected frames.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+template<typename Sampler>
+static std::vector<unsigned char> flatten( const typename Sampler::WindowExport& frame )
+{
+	std::vector<unsigned char> bytes( frame.getByteSize() );
+	frame.copyTo( bytes.data() );
+	return bytes;
+}
+
+template<typename Sampler>
+static bool sameValid( const Sampler& lhs, const Sampler& rhs )
+{
+	typename Sampler::Window a = lhs.tail( lhs.getNumValidSamples() );
+	typename Sampler::Window b = rhs.tail( rhs.getNumValidSamples() );
+	return lhs.getNumSamples() == rhs.getNumSamples() && a.size() == b.size() && std::equal( a.begin(), a.end(), b.begin() );
+}
+
+// Full and delta frames through a receiver whose window must track the sender's
+static void testExportImport()
+{
+	typedef RingSamplerT<float, float> Sampler;
+	Sampler sender( 8 );
+	Sampler receiver( 3 );
+	ExportCursor cursor;
+	for ( int i = 0; i < 5; ++i ) {
+		sender.pushBack( (float)i );
+	}
+	Sampler::WindowExport frame = sender.exportWindow( cursor );
+	std::vector<unsigned char> bytes = flatten<Sampler>( frame );
+	CHECK( !frame.isDelta() && frame.getHeader().count == 5 );
+	CHECK( receiver.importWindow( bytes.data(), bytes.size() ) );
+	CHECK( sameValid( sender, receiver ) );
+
+	// Deltas across the ring's wrap, including empty ones
+	for ( int round = 0; round < 20; ++round ) {
+		for ( int i = 0; i < round % 4; ++i ) {
+			sender.pushBack( (float)( 100 * round + i ) );
+		}
+		frame = sender.exportWindow( cursor );
+		bytes = flatten<Sampler>( frame );
+		CHECK( frame.isDelta() && frame.getHeader().count == (uint32_t)( round % 4 ) );
+		CHECK( receiver.importWindow( bytes.data(), bytes.size() ) );
+		CHECK( sameValid( sender, receiver ) );
+	}
+
+	// An edit, or more pushes than the window holds, forces a full frame
+	sender.eraseSample( 2 );
+	frame = sender.exportWindow( cursor );
+	bytes = flatten<Sampler>( frame );
+	CHECK( !frame.isDelta() );
+	CHECK( receiver.importWindow( bytes.data(), bytes.size() ) && sameValid( sender, receiver ) );
+	for ( int i = 0; i < 20; ++i ) {
+		sender.pushBack( (float)-i );
+	}
+	frame = sender.exportWindow( cursor );
+	bytes = flatten<Sampler>( frame );
+	CHECK( !frame.isDelta() && frame.getHeader().count == 8 );
+	CHECK( receiver.importWindow( bytes.data(), bytes.size() ) && sameValid( sender, receiver ) );
+
+	// A delta that does not follow on from the receiver's window is rejected
+	sender.pushBack( 42.0f );
+	frame = sender.exportWindow( cursor );
+	bytes = flatten<Sampler>( frame );
+	Sampler stale( receiver );
+	stale.pushBack( 7.0f );
+	CHECK( frame.isDelta() );
+	CHECK( !stale.importWindow( bytes.data(), bytes.size() ) );
+	CHECK( !receiver.importWindow( bytes.data(), bytes.size() - 1 ) );
+	CHECK( receiver.importWindow( bytes.data(), bytes.size() ) && sameValid( sender, receiver ) );
+
+	// Frames carry their sample type
+	SamplerT<double, double> other;
+	CHECK( !other.importWindow( bytes.data(), bytes.size() ) );
+}
+
+/*
+ * Counts are 64-bit on the wire, so a window is never truncated, and a
+ * count that only matches the payload after overflowing is rejected.
+ */
+static void testWideCounts()
+{
+	typedef SamplerT<float, float> Sampler;
+	CHECK( sizeof( ExportHeader().count ) == 8 && sizeof( ExportHeader().numSamples ) == 8 );
+	Sampler sender( 70000 );
+	std::vector<float> block( 70000, 1.0f );
+	sender.append( block.data(), block.size() );
+	ExportCursor cursor;
+	std::vector<unsigned char> bytes = flatten<Sampler>( sender.exportWindow( cursor ) );
+	Sampler receiver;
+	CHECK( receiver.importWindow( bytes.data(), bytes.size() ) && sameValid( sender, receiver ) );
+
+	ExportHeader header;
+	std::memcpy( &header, bytes.data(), sizeof( header ) );
+	header.count = ( (uint64_t)1 << 62 ) + 2;
+	std::memcpy( bytes.data(), &header, sizeof( header ) );
+	CHECK( !receiver.importWindow( bytes.data(), sizeof( header ) + 2 * sizeof( float ) ) );
+	CHECK( receiver.getNumSamples() == 70000 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testExportImport();
+	testWideCounts();
+	return report();
+}
@@ -0,0 +1,207 @@
+/*
+ * Process graphs: memoized evaluation, error codes and declaration checks.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_INPUT, ID_MEAN, ID_MISSING, ID_NODE, ID_NULL, ID_OUTPUT, ID_SUM, ID_VARIANCE };
+
+// Derived processes, memoized per evaluation or with caching per generation, and how bad IDs are reported
+static void testGraph()
+{
+	typedef SamplerT<float, float> Sampler;
+	Sampler sampler( 4 );
+	int numSums = 0;
+	sampler.process( ID_SUM, [ & ]( const Sampler::Window& window ) { ++numSums; return reduce::sum( window ); } );
+	sampler.process( ID_MEAN, { ID_SUM }, []( const Sampler::Window& window, const float* inputs )
+	{
+		return inputs[ 0 ] / window.size();
+	} );
+	sampler.process( ID_VARIANCE, { ID_MEAN }, []( const Sampler::Window& window, const float* inputs )
+	{
+		float total = 0.0f;
+		for ( float v : window ) {
+			total += ( v - inputs[ 0 ] ) * ( v - inputs[ 0 ] );
+		}
+		return total / window.size();
+	} );
+	sampler.process( ID_OUTPUT, { ID_MEAN, ID_VARIANCE }, []( const Sampler::Window&, const float* inputs )
+	{
+		return inputs[ 0 ] + inputs[ 1 ];
+	} );
+	for ( int i = 1; i <= 4; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+
+	// Without caching, shared inputs run once per evaluation but results do not outlive it
+	CHECK( sampler.runProcess( ID_OUTPUT ) == 3.75f );
+	CHECK( numSums == 1 );
+	CHECK( sampler.runProcess( ID_MEAN ) == 2.5f );
+	CHECK( numSums == 2 );
+	CHECK( sampler.runProcess( ID_SUM ) == 10.0f );
+	CHECK( numSums == 3 );
+
+	// With caching, they last until the samples change
+	sampler.setCaching( true );
+	numSums = 0;
+	CHECK( sampler.runProcess( ID_VARIANCE ) == 1.25f );
+	CHECK( sampler.runProcess( ID_MEAN ) == 2.5f );
+	CHECK( sampler.runProcess( ID_SUM ) == 10.0f );
+	CHECK( numSums == 1 );
+	sampler.pushBack( 5.0f );
+	CHECK( sampler.runProcess( ID_MEAN ) == 3.5f );
+	CHECK( numSums == 2 );
+
+	// Editing through getSamples() counts as a change
+	sampler.getSamples()[ 0 ] = 6.0f;
+	CHECK( sampler.runProcess( ID_SUM ) == 18.0f );
+	CHECK( numSums == 3 );
+	sampler.setCaching( false );
+	CHECK( sampler.getInputs( ID_VARIANCE ).size() == 1 && sampler.getInputs( ID_SUM ).empty() );
+
+	// Error codes through tryRunProcess(), which never throws
+	Sampler graph( 2 );
+	graph.process( ID_INPUT, []( const Sampler::Window& ) { return 1.0f; } );
+	graph.process( ID_NODE, { ID_INPUT }, []( const Sampler::Window&, const float* inputs ) { return inputs[ 0 ]; } );
+	graph.process( ID_OUTPUT, { ID_NODE }, []( const Sampler::Window&, const float* inputs ) { return inputs[ 0 ] + 1.0f; } );
+	float value = -1.0f;
+	CHECK( graph.tryRunProcess( ID_OUTPUT, value ) == PROCESS_NONE && value == 2.0f );
+	CHECK( graph.tryRunProcess( ID_MISSING, value ) == PROCESS_NOT_FOUND );
+	graph.process( ID_NULL, nullptr );
+	CHECK( graph.tryRunProcess( ID_NULL, value ) == PROCESS_UNDEFINED );
+	graph.eraseProcess( ID_INPUT );
+	value = -1.0f;
+	CHECK( graph.tryRunProcess( ID_OUTPUT, value ) == PROCESS_NOT_FOUND && value == -1.0f );
+	CHECK( graph.tryRunProcess( ID_OUTPUT, graph.getWindow(), value ) == PROCESS_NOT_FOUND );
+	graph.process( ID_INPUT, nullptr );
+	CHECK( graph.tryRunProcess( ID_NODE, value ) == PROCESS_UNDEFINED );
+	graph.process( ID_INPUT, []( const Sampler::Window& ) { return 3.0f; } );
+	CHECK( graph.tryRunProcess( ID_OUTPUT, value ) == PROCESS_NONE && value == 4.0f );
+
+	// A trigger on an undefined process is skipped rather than thrown from pushBack()
+	int numEvents = 0;
+	graph.trigger( ID_NULL, TRIGGER_RATE, 0.0f, [ & ]( const TriggerEventT<float>& ) { ++numEvents; } );
+	graph.pushBack( 1.0f );
+	graph.pushBack( 2.0f );
+	CHECK( numEvents == 0 );
+
+#if defined( SAMPLING_EXCEPTIONS )
+	bool threw = false;
+	try {
+		graph.process( ID_INPUT, { ID_OUTPUT }, []( const Sampler::Window&, const float* ) { return 0.0f; } );
+	} catch ( const ExcProcCycle& e ) {
+		threw = e.getIndex() == ID_INPUT;
+	}
+	CHECK( threw );
+	CHECK( graph.runProcess( ID_OUTPUT ) == 4.0f );
+
+	threw = false;
+	try {
+		graph.process( ID_NODE, { ID_MISSING }, []( const Sampler::Window&, const float* ) { return 0.0f; } );
+	} catch ( const ExcProcNotFound& e ) {
+		threw = e.getIndex() == ID_MISSING;
+	}
+	CHECK( threw );
+
+	threw = false;
+	try {
+		graph.runProcess( ID_MISSING );
+	} catch ( const ExcProcNotFound& e ) {
+		threw = e.getIndex() == ID_MISSING;
+	}
+	CHECK( threw );
+#endif
+}
+
+// A result type that counts default constructions and live instances
+struct Result
+{
+	static int sNumDefaults;
+	static int sNumLive;
+
+	Result()
+		: value( 0.0f )
+	{
+		++sNumDefaults;
+		++sNumLive;
+	}
+
+	Result( float v )
+		: value( v )
+	{
+		++sNumLive;
+	}
+
+	Result( const Result& rhs )
+		: value( rhs.value )
+	{
+		++sNumLive;
+	}
+
+	~Result()
+	{
+		--sNumLive;
+	}
+
+	Result& operator=( const Result& rhs )
+	{
+		value = rhs.value;
+		return *this;
+	}
+
+	float value;
+};
+
+int Result::sNumDefaults	= 0;
+int Result::sNumLive		= 0;
+
+/*
+ * Inputs are constructed only as they are computed, spill to the heap
+ * past the inline eight, and are destroyed however the node ends.
+ */
+static void testNodeInputs()
+{
+	typedef SamplerT<float, Result> Sampler;
+	{
+		Sampler sampler( 4 );
+		std::vector<size_t> inputs;
+		for ( size_t i = 0; i < 10; ++i ) {
+			sampler.process( 100 + i, [ i ]( const Sampler::Window& window ) { return Result( reduce::sum( window ) + (float)i ); } );
+			inputs.push_back( 100 + i );
+		}
+		sampler.process( ID_SUM, { 100, 101 }, []( const Sampler::Window&, const Result* in )
+		{
+			return Result( in[ 0 ].value + in[ 1 ].value );
+		} );
+		sampler.process( ID_OUTPUT, inputs, []( const Sampler::Window&, const Result* in )
+		{
+			float total = 0.0f;
+			for ( size_t i = 0; i < 10; ++i ) {
+				total += in[ i ].value;
+			}
+			return Result( total );
+		} );
+		sampler.pushBack( 1.0f );
+		Result::sNumDefaults = 0;
+		CHECK( sampler.runProcess( ID_SUM ).value == 3.0f );
+		CHECK( Result::sNumDefaults < 8 );
+		CHECK( sampler.runProcess( ID_OUTPUT ).value == 55.0f );
+
+		// An input that fails part way leaves nothing behind once the sampler is gone
+		sampler.process( 105, nullptr );
+		Result output;
+		CHECK( sampler.tryRunProcess( ID_OUTPUT, output ) == PROCESS_UNDEFINED );
+	}
+	CHECK( Result::sNumLive == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testGraph();
+	testNodeInputs();
+	return report();
+}
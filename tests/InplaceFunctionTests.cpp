@@ -0,0 +1,168 @@
+/*
+ * InplaceFunctionT: small callables stay in the buffer without touching the
+ * heap, large ones fall back to it, and every copy, move and reset
+ * destroys exactly what it made.
+ */
+
+#include "Testing.h"
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+using namespace sampling;
+
+static int sNumAllocations = 0;
+
+void* operator new( size_t size )
+{
+	++sNumAllocations;
+	void* p = std::malloc( size > 0 ? size : 1 );
+	if ( p == nullptr ) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+	std::free( p );
+}
+
+// A callable of Size bytes, counting live instances
+template<size_t Size>
+struct Counted
+{
+	static int sNumLive;
+
+	explicit Counted( int v )
+		: value( v )
+	{
+		++sNumLive;
+	}
+
+	Counted( const Counted& rhs )
+		: value( rhs.value )
+	{
+		++sNumLive;
+	}
+
+	Counted( Counted&& rhs ) noexcept
+		: value( rhs.value )
+	{
+		++sNumLive;
+	}
+
+	~Counted()
+	{
+		--sNumLive;
+	}
+
+	int operator()( int x ) const
+	{
+		return x + value;
+	}
+
+	int		value;
+	char	padding[ Size ];
+};
+
+template<size_t Size>
+int Counted<Size>::sNumLive = 0;
+
+typedef InplaceFunctionT<int( int )> Function;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copies, moves and assignments of a callable held in place or on the heap
+template<typename F>
+static void testOwnership( bool inplace )
+{
+	{
+		int allocations = sNumAllocations;
+		Function a( F( 1 ) );
+		CHECK( a.isInplace() == inplace && a( 2 ) == 3 );
+		CHECK( ( sNumAllocations == allocations ) == inplace );
+		CHECK( F::sNumLive == 1 );
+
+		Function b( a );
+		CHECK( F::sNumLive == 2 && b( 1 ) == 2 );
+		Function c( std::move( a ) );
+		CHECK( F::sNumLive == 2 && a == nullptr && c != nullptr && c( 0 ) == 1 );
+		a = c;
+		CHECK( F::sNumLive == 3 && a( 5 ) == 6 );
+		b = std::move( c );
+		CHECK( F::sNumLive == 2 && !c && b( 5 ) == 6 );
+		Function& self = b;
+		b = self;
+		CHECK( F::sNumLive == 2 && b( 5 ) == 6 );
+		a = F( 10 );
+		CHECK( F::sNumLive == 2 && a( 5 ) == 15 );
+		a = nullptr;
+		CHECK( F::sNumLive == 1 && !a );
+	}
+	CHECK( F::sNumLive == 0 );
+}
+
+static int twice( int x )
+{
+	return x * 2;
+}
+
+// Empty states, plain functions, move-only arguments and captured state
+static void testCalls()
+{
+	Function empty;
+	CHECK( empty == nullptr && !empty && empty.isInplace() );
+	CHECK( Function( std::function<int( int )>() ) == nullptr );
+	int ( *none )( int ) = nullptr;
+	CHECK( Function( none ) == nullptr );
+	CHECK( Function( &twice )( 4 ) == 8 );
+	CHECK( Function( std::function<int( int )>( &twice ) )( 5 ) == 10 );
+
+	std::shared_ptr<int> shared( new int( 7 ) );
+	InplaceFunctionT<std::unique_ptr<int>( std::unique_ptr<int>&& )> consume( [ shared ]( std::unique_ptr<int>&& p )
+	{
+		*p += *shared;
+		return std::move( p );
+	} );
+	std::unique_ptr<int> result = consume( std::unique_ptr<int>( new int( 1 ) ) );
+	CHECK( *result == 8 );
+	consume = nullptr;
+	CHECK( shared.use_count() == 1 );
+}
+
+// Processes with small captures are stored and run without allocating
+static void testProcesses()
+{
+	typedef SamplerT<float, float, RingStorageT<float> > Sampler;
+	Sampler sampler( 8 );
+	for ( int i = 0; i < 8; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	float scale = 2.0f, offset = 1.0f;
+	sampler.process( 0, [ scale, offset ]( const Sampler::Window& window ) { return window.back() * scale + offset; } );
+	sampler.process( 1, [ scale ]( const Sampler::Window& window ) { return reduce::sum( window ) * scale; } );
+
+	int allocations = sNumAllocations;
+	sampler.process( 0, [ scale, offset ]( const Sampler::Window& window ) { return window.front() * scale + offset; } );
+	CHECK( sampler.runProcess( 0 ) == 1.0f && sampler.runProcess( 1 ) == 56.0f );
+	CHECK( sNumAllocations == allocations );
+	CHECK( sampler.getProcess( 0 ).isInplace() );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testOwnership<Counted<8> >( true );
+	testOwnership<Counted<Function::kCapacity> >( false );
+	testCalls();
+	testProcesses();
+	return report();
+}
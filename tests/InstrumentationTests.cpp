@@ -0,0 +1,80 @@
+/*
+ * Instrumentation: per-process counters and generations, ingest counts,
+ * and the empty stats of an uninstrumented sampler.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_MAX, ID_SUM };
+
+static void testStats()
+{
+	typedef SamplerT<float, float, RingStorageT<float>, Instrumentation> Sampler;
+	Sampler sampler( 8 );
+	sampler.setCaching( true );
+	sampler.process( ID_SUM, []( const Sampler::Window& window ) { return reduce::sum( window ); } );
+	sampler.process( ID_MAX, []( const Sampler::Window& window ) { return reduce::maximum( window ); } );
+	float block[] = { 1.0f, 2.0f, 3.0f };
+	sampler.pushBack( 0.0f );
+	sampler.append( block, 3 );
+	CHECK( sampler.getStats().numIngested == 4 );
+
+	// The first run only records its generation; a hit changes neither
+	uint64_t first = sampler.getGeneration();
+	sampler.runProcess( ID_SUM );
+	sampler.runProcess( ID_SUM );
+	ProcessStats stats = sampler.getStats().getProcess( ID_SUM );
+	CHECK( stats.calls == 1 && stats.cacheHits == 1 );
+	CHECK( stats.runGeneration == first && stats.invalidGeneration == 0 );
+
+	// Pushes since then: the first of them is what made the result stale
+	sampler.pushBack( 4.0f );
+	uint64_t stale = sampler.getGeneration();
+	sampler.pushBack( 5.0f );
+	sampler.runProcess( ID_SUM );
+	stats = sampler.getStats().getProcess( ID_SUM );
+	CHECK( stats.calls == 2 && stats.runGeneration == sampler.getGeneration() );
+	CHECK( stats.invalidGeneration == stale );
+
+	// So does an invalidate()
+	sampler.invalidate();
+	sampler.runProcess( ID_SUM );
+	CHECK( sampler.getStats().getProcess( ID_SUM ).invalidGeneration == sampler.getGeneration() );
+
+	// Replacing the process drops its result without a new generation
+	sampler.process( ID_SUM, []( const Sampler::Window& window ) { return reduce::sum( window ) * 2.0f; } );
+	sampler.runProcess( ID_SUM );
+	CHECK( sampler.getStats().getProcess( ID_SUM ).invalidGeneration == sampler.getGeneration() );
+
+	// Runs on another window are timed but keep the sampler's generations
+	stats = sampler.getStats().getProcess( ID_MAX );
+	sampler.runProcess( ID_MAX, sampler.getWindow().tail( 2 ) );
+	CHECK( sampler.getStats().getProcess( ID_MAX ).calls == stats.calls + 1 );
+	CHECK( sampler.getStats().getProcess( ID_MAX ).runGeneration == stats.runGeneration );
+	CHECK( sampler.getStats().getProcess( 100 ).calls == 0 );
+
+	sampler.resetStats();
+	CHECK( sampler.getStats().numIngested == 0 && sampler.getStats().processes.empty() );
+}
+
+// Without the policy the hooks are empty and getStats() stays zero
+static void testDisabled()
+{
+	SamplerT<float, float> sampler( 4 );
+	sampler.process( ID_SUM, []( const WindowT<const float>& window ) { return reduce::sum( window ); } );
+	sampler.pushBack( 1.0f );
+	sampler.runProcess( ID_SUM );
+	CHECK( !NullInstrumentation::kEnabled && NullInstrumentation::now() == 0 );
+	CHECK( sampler.getStats().numIngested == 0 && sampler.getStats().getProcess( ID_SUM ).calls == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testStats();
+	testDisabled();
+	return report();
+}
@@ -0,0 +1,80 @@
+/*
+ * File-backed rings: resuming a window and recovering from a torn write.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+#if defined( SAMPLING_MMAP )
+
+// Exposes the seqlock so a test can leave a write half done, as a crash would
+class TornRingStorage : public MappedRingStorageT<float>
+{
+public:
+	TornRingStorage( const char* path, size_t capacity )
+		: MappedRingStorageT<float>( path, capacity )
+	{
+	}
+
+	inline void tear()
+	{
+		beginWrite();
+	}
+};
+
+// A file-backed window survives its process and recovers from a torn write
+static void testMappedResume()
+{
+	typedef SamplerT<float, float, MappedRingStorageT<float> > Sampler;
+	std::string path = "sampling_tests_" + std::to_string( (long long)::getpid() ) + ".ring";
+	::unlink( path.c_str() );
+	{
+		Sampler sampler( 5, MappedRingStorageT<float>( path.c_str(), 8 ) );
+		CHECK( sampler.getStorage().isFileBacked() );
+		for ( int i = 0; i < 23; ++i ) {
+			sampler.pushBack( (float)i );
+		}
+	}
+	{
+		Sampler sampler( 5, MappedRingStorageT<float>( path.c_str(), 8 ) );
+		CHECK( sampler.getNumValidSamples() == 5 );
+		CHECK( sampler.getSamples()[ 0 ] == 18.0f && sampler.getSamples()[ 4 ] == 22.0f );
+		sampler.pushBack( 23.0f );
+		CHECK( sampler.getSamples()[ 0 ] == 19.0f && sampler.getSamples()[ 4 ] == 23.0f );
+	}
+	{
+		MappedRingReaderT<float> reader( path.c_str() );
+		std::vector<float> samples;
+		reader.snapshot( samples );
+		CHECK( samples.size() == 5 && samples.front() == 19.0f && samples.back() == 23.0f );
+	}
+	{
+		TornRingStorage torn( path.c_str(), 8 );
+		torn.tear();
+		CHECK( ( torn.getGeneration() & 1 ) == 1 );
+	}
+	{
+		// Resuming evens the generation, so readers no longer wait on the torn write
+		MappedRingStorageT<float> storage( path.c_str(), 8 );
+		CHECK( ( storage.getGeneration() & 1 ) == 0 );
+		storage.pushBack( 24.0f );
+		MappedRingReaderT<float> reader( path.c_str() );
+		std::vector<float> samples;
+		reader.snapshot( samples );
+		CHECK( samples.size() == 6 && samples.back() == 24.0f );
+	}
+	::unlink( path.c_str() );
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+#if defined( SAMPLING_MMAP )
+	testMappedResume();
+#endif
+	return report();
+}
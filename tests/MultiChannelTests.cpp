@@ -0,0 +1,118 @@
+/*
+ * Multi-channel samplers: every channel matches a single sampler fed the
+ * same values, however the frames arrive.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_MAX, ID_MEAN, ID_SUM };
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Frames pushed one at a time and appended interleaved, against one reference sampler per channel
+template<typename S>
+static void testChannels()
+{
+	typedef MultiChannelSamplerT<float, float, 4, S> Sampler;
+	typedef SamplerT<float, float, S> Reference;
+	Sampler sampler( 16 );
+	sampler.process( ID_SUM, []( const WindowT<const float>& window ) { return reduce::sum( window ); } );
+	sampler.kernel( ID_MAX, MaxKernelT<float, float>() ).accumulate( ID_MEAN, RunningMeanT<float, float>() );
+	CHECK( sampler.getNumChannels() == 4 && sampler.getNumSamples() == 16 );
+
+	std::vector<Reference> references( 4, Reference( 16 ) );
+	for ( Reference& reference : references ) {
+		reference.process( ID_SUM, []( const WindowT<const float>& window ) { return reduce::sum( window ); } );
+		reference.kernel( ID_MAX, MaxKernelT<float, float>() ).accumulate( ID_MEAN, RunningMeanT<float, float>() );
+	}
+
+	std::mt19937 rng( 17 );
+	for ( int i = 0; i < 200; ++i ) {
+		if ( i % 9 == 0 ) {
+			// Interleaved frames, frame after frame
+			size_t count = 1 + rng() % 5;
+			std::vector<float> frames( count * 4 );
+			for ( float& v : frames ) {
+				v = (float)( rng() % 100 );
+			}
+			sampler.append( frames.data(), count );
+			for ( size_t f = 0; f < count; ++f ) {
+				for ( size_t c = 0; c < 4; ++c ) {
+					references[ c ].pushBack( frames[ f * 4 + c ] );
+				}
+			}
+		} else {
+			typename Sampler::Frame frame;
+			for ( size_t c = 0; c < 4; ++c ) {
+				frame[ c ] = (float)( rng() % 100 );
+				references[ c ].pushBack( frame[ c ] );
+			}
+			if ( i % 2 == 0 ) {
+				sampler.pushBack( frame );
+			} else {
+				sampler.pushBack( frame.data() );
+			}
+		}
+
+		CHECK( sampler.getSize() == references[ 0 ].getWindow().size() );
+		CHECK( sampler.getNumValidSamples() == references[ 0 ].getNumValidSamples() );
+		std::array<float, 4> sums	= sampler.runProcess( ID_SUM );
+		std::array<float, 4> maxima	= sampler.runProcess( ID_MAX );
+		float means[ 4 ];
+		sampler.runProcess( ID_MEAN, means );
+		for ( size_t c = 0; c < 4; ++c ) {
+			const Reference& reference = references[ c ];
+			CHECK( matches( sampler.getWindow( c ), std::vector<float>( reference.getWindow().begin(), reference.getWindow().end() ) ) );
+			CHECK( sums[ c ] == references[ c ].runProcess( ID_SUM ) );
+			CHECK( maxima[ c ] == references[ c ].runProcess( ID_MAX ) );
+			CHECK( means[ c ] == references[ c ].runProcess( ID_MEAN ) );
+		}
+		size_t last = sampler.getSize() - 1;
+		typename Sampler::Frame newest = sampler.getSample( last );
+		for ( size_t c = 0; c < 4; ++c ) {
+			CHECK( newest[ c ] == references[ c ].getWindow().back() );
+		}
+	}
+}
+
+// Channels keep processes of their own, copies are independent, and resizes reach every channel
+static void testChannelState()
+{
+	typedef MultiChannelSamplerT<float, float, 3, RingStorageT<float> > Sampler;
+	Sampler sampler( 4 );
+	sampler.process( ID_SUM, []( const WindowT<const float>& window ) { return reduce::sum( window ); } );
+	sampler.getChannel( 2 ).process( ID_MAX, []() { return 9.0f; } );
+	CHECK( sampler.getChannel( 2 ).runProcess( ID_MAX ) == 9.0f );
+	float out = 0.0f;
+	CHECK( sampler.getChannel( 0 ).tryRunProcess( ID_MAX, out ) == PROCESS_NOT_FOUND );
+	for ( int i = 0; i < 6; ++i ) {
+		sampler.pushBack( { (float)i, (float)i * 2, (float)i * 3 } );
+	}
+
+	Sampler copy( sampler );
+	copy.pushBack( { 0.0f, 0.0f, 0.0f } );
+	CHECK( copy.runProcess( ID_SUM )[ 0 ] == 12.0f );
+	CHECK( sampler.runProcess( ID_SUM )[ 0 ] == 14.0f && sampler.runProcess( ID_SUM )[ 2 ] == 42.0f );
+
+	sampler.eraseProcess( ID_SUM );
+	sampler.setNumSamples( 8 );
+	sampler.clearSamples();
+	for ( size_t c = 0; c < 3; ++c ) {
+		CHECK( sampler.getChannel( c ).tryRunProcess( ID_SUM, out ) == PROCESS_NOT_FOUND );
+		CHECK( sampler.getChannel( c ).getNumSamples() == 8 );
+		CHECK( sampler.getChannel( c ).getNumValidSamples() == 0 );
+	}
+	CHECK( copy.getChannel( 1 ).tryRunProcess( ID_SUM, out ) == PROCESS_NONE && out == 24.0f );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testChannels<VectorStorageT<float> >();
+	testChannels<RingStorageT<float> >();
+	testChannelState();
+	return report();
+}
@@ -0,0 +1,115 @@
+/*
+ * runProcessesParallel() on a thread pool against runProcesses(), with
+ * repeated IDs, stateful kernels, accumulators, graph nodes and errors.
+ * A repeated kernel must be fed once by either.
+ */
+
+#include "Testing.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace sampling;
+
+enum { ID_COUNT, ID_DOUBLE, ID_KERNEL, ID_MEAN, ID_MISSING, ID_NODE, ID_SUM, ID_THROW };
+
+// A sum kernel that records which thread finished it
+class ThreadKernel : public KernelT<float, float>
+{
+public:
+	static std::thread::id sThread;
+
+	void begin() override
+	{
+		mSum = 0.0f;
+	}
+
+	KernelT<float, float>* clone() const override
+	{
+		return new ThreadKernel( *this );
+	}
+
+	float end() override
+	{
+		sThread = std::this_thread::get_id();
+		return mSum;
+	}
+
+	void update( const SpanT<const float>& block ) override
+	{
+		for ( float v : block ) {
+			mSum += v;
+		}
+	}
+protected:
+	float mSum = 0.0f;
+};
+
+std::thread::id ThreadKernel::sThread;
+
+static void testParallel( bool caching )
+{
+	typedef SamplerT<float, float> Sampler;
+	ThreadPool pool( 4 );
+	Sampler sampler( 32 );
+	sampler.setCaching( caching );
+	std::atomic<int> numCounts( 0 );
+	sampler.process( ID_COUNT, [ & ]( const Sampler::Window& window ) { ++numCounts; return (float)window.size(); } );
+	sampler.process( ID_SUM, []( const Sampler::Window& window ) { return reduce::sum( window ); } );
+	sampler.process( ID_DOUBLE, { ID_SUM }, []( const Sampler::Window&, const float* inputs ) { return inputs[ 0 ] * 2.0f; } );
+	sampler.kernel( ID_KERNEL, ThreadKernel() );
+	sampler.accumulate( ID_MEAN, RunningMeanT<float>() );
+	for ( int i = 0; i < 40; ++i ) {
+		sampler.pushBack( (float)( i % 7 ) );
+	}
+
+	// Repeats of a plain process and of the kernel each run once and share the result
+	std::vector<size_t> indices = { ID_SUM, ID_COUNT, ID_KERNEL, ID_COUNT, ID_MEAN, ID_KERNEL, ID_DOUBLE, ID_SUM, ID_COUNT };
+	std::vector<float> expected, results;
+	sampler.runProcesses( indices, expected );
+	sampler.setExecutor( pool.getExecutor() );
+	for ( int pass = 0; pass < 50; ++pass ) {
+		sampler.pushBack( (float)pass );
+		sampler.setExecutor( nullptr );
+		sampler.runProcesses( indices, expected );
+		sampler.setExecutor( pool.getExecutor() );
+		numCounts = 0;
+		ThreadKernel::sThread = std::thread::id();
+		sampler.runProcessesParallel( indices, results );
+		CHECK( results == expected );
+		CHECK( numCounts == ( caching ? 0 : 1 ) );
+		CHECK( caching || ThreadKernel::sThread == std::this_thread::get_id() );
+	}
+	CHECK( results[ 2 ] == reduce::sum( sampler.getWindow() ) && results[ 5 ] == results[ 2 ] );
+	CHECK( results[ 6 ] == 2.0f * results[ 0 ] && results[ 8 ] == 32.0f );
+
+#if defined( SAMPLING_EXCEPTIONS )
+	// A bad ID throws before anything runs, and a throwing process surfaces here
+	bool threw = false;
+	std::vector<size_t> missing = { ID_SUM, ID_MISSING };
+	try {
+		sampler.runProcessesParallel( missing, results );
+	} catch ( const ExcProcNotFound& ) {
+		threw = true;
+	}
+	CHECK( threw );
+	sampler.process( ID_THROW, []( const Sampler::Window& ) -> float { throw std::runtime_error( "process" ); } );
+	std::vector<size_t> throwing = { ID_SUM, ID_THROW, ID_COUNT };
+	threw = false;
+	try {
+		sampler.runProcessesParallel( throwing, results );
+	} catch ( const std::runtime_error& ) {
+		threw = true;
+	}
+	CHECK( threw );
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testParallel( false );
+	testParallel( true );
+	return report();
+}
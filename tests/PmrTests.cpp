@@ -0,0 +1,88 @@
+/*
+ * Samplers on a std::pmr arena: everything, copies included, allocates
+ * from the arena and never from the default resource.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+#if __cplusplus >= 201703L && defined( __has_include )
+#if __has_include( <memory_resource> )
+#define SAMPLING_TEST_PMR
+
+enum { ID_MEAN, ID_SUM };
+
+// Counts the bytes allocated through it
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	size_t mNumBytes = 0;
+protected:
+	void* do_allocate( size_t bytes, size_t alignment ) override
+	{
+		mNumBytes += bytes;
+		return std::pmr::new_delete_resource()->allocate( bytes, alignment );
+	}
+
+	void do_deallocate( void* p, size_t bytes, size_t alignment ) override
+	{
+		std::pmr::new_delete_resource()->deallocate( p, bytes, alignment );
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& rhs ) const noexcept override
+	{
+		return this == &rhs;
+	}
+};
+
+/*
+ * With the default resource swapped for one that always throws, building,
+ * copying, assigning and moving a sampler only succeed if each of them
+ * stays on the arena.
+ */
+template<typename Sampler>
+static void testArena()
+{
+	CountingResource arena;
+	std::pmr::memory_resource* previous = std::pmr::set_default_resource( std::pmr::null_memory_resource() );
+	try {
+		Sampler sampler( 16, &arena );
+		sampler.process( ID_SUM, []( const typename Sampler::Window& window ) { return reduce::sum( window ); } );
+		sampler.accumulate( ID_MEAN, RunningMeanT<float>() );
+		for ( int i = 0; i < 40; ++i ) {
+			sampler.pushBack( (float)i );
+		}
+		size_t numBytes = arena.mNumBytes;
+
+		Sampler copy( sampler );
+		CHECK( copy.getAllocator().resource() == &arena );
+		CHECK( arena.mNumBytes > numBytes );
+		copy.pushBack( 1.0f );
+		CHECK( copy.runProcess( ID_SUM ) == reduce::sum( copy.getWindow() ) );
+		CHECK( std::fabs( copy.runProcess( ID_MEAN ) - reduce::sum( copy.getWindow() ) / 16.0f ) < 1e-4f );
+
+		Sampler assigned( 4, &arena );
+		assigned = copy;
+		CHECK( matches( assigned.getWindow(), std::vector<float>( copy.getWindow().begin(), copy.getWindow().end() ) ) );
+		Sampler moved( std::move( assigned ) );
+		CHECK( moved.getAllocator().resource() == &arena && moved.runProcess( ID_SUM ) == copy.runProcess( ID_SUM ) );
+	} catch ( const std::bad_alloc& ) {
+		CHECK( !"allocated from the default resource" );
+	}
+	std::pmr::set_default_resource( previous );
+}
+
+#endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+#if defined( SAMPLING_TEST_PMR )
+	testArena<pmr::SamplerT<float, float> >();
+	testArena<pmr::RingSamplerT<float, float> >();
+#endif
+	return report();
+}
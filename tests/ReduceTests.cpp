@@ -0,0 +1,108 @@
+/*
+ * The built-in reductions against the scalar loops, for every length and
+ * alignment around the lane widths. CMakeLists.txt builds this file once
+ * per SIMD path (none, the compiler's default, SSE4.1, AVX and AVX2), so
+ * each run checks the lanes that build selected.
+ */
+
+#include "Testing.h"
+
+#include <limits>
+
+using namespace sampling;
+
+// Which lanes this build uses for T
+template<typename T>
+static const char* getPath()
+{
+	return std::is_base_of<reduce::ScalarT<T>, reduce::KernelsT<T> >::value ? "scalar" : "simd";
+}
+
+// Sums may be reassociated by the lanes; everything else must match exactly
+template<typename T>
+static bool near( T a, T b, T scale, size_t count )
+{
+	if ( std::is_integral<T>::value ) {
+		return a == b;
+	}
+	return std::fabs( (double)a - (double)b ) <= (double)scale * (double)( count + 1 ) * (double)std::numeric_limits<T>::epsilon();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static void testReductions()
+{
+	typedef reduce::ScalarT<T> Scalar;
+	const size_t kMaxCount	= 70;
+	const size_t kMaxOffset	= 9;
+	std::mt19937 rng( 6 );
+	std::vector<T> a( kMaxCount + kMaxOffset ), b( a.size() );
+	for ( size_t i = 0; i < a.size(); ++i ) {
+		// Small values keep int32_t dot products in range
+		a[ i ] = (T)( (int)( rng() % 201 ) - 100 ) / ( std::is_integral<T>::value ? 1 : 8 );
+		b[ i ] = (T)( (int)( rng() % 201 ) - 100 ) / ( std::is_integral<T>::value ? 1 : 8 );
+	}
+	// The extremes land in every lane position
+	a[ 13 ] = (T)1000;
+	a[ 40 ] = (T)-1000;
+
+	for ( size_t offset = 0; offset < kMaxOffset; ++offset ) {
+		for ( size_t count = 0; count <= kMaxCount; ++count ) {
+			const T* x = a.data() + offset;
+			const T* y = b.data() + offset;
+			CHECK( reduce::maximum( x, count ) == Scalar::maximum( x, count ) );
+			CHECK( reduce::minimum( x, count ) == Scalar::minimum( x, count ) );
+			CHECK( near( reduce::sum( x, count ), Scalar::sum( x, count ), (T)1000, count ) );
+			CHECK( near( reduce::sumSquares( x, count ), Scalar::dot( x, x, count ), (T)1000000, count ) );
+			CHECK( near( reduce::dot( x, y, count ), Scalar::dot( x, y, count ), (T)100000, count ) );
+
+			std::vector<T> expected( b.begin() + offset, b.begin() + offset + count ), actual( expected );
+			Scalar::addInto( expected.data(), x, count );
+			reduce::addInto( actual.data(), x, count );
+			CHECK( actual == expected );
+			Scalar::maximumInto( expected.data(), y, count );
+			reduce::maximumInto( actual.data(), y, count );
+			CHECK( actual == expected );
+			Scalar::minimumInto( expected.data(), x, count );
+			reduce::minimumInto( actual.data(), x, count );
+			CHECK( actual == expected );
+		}
+	}
+
+	// Windows split anywhere reduce as their two segments
+	for ( size_t split = 0; split <= 40; ++split ) {
+		WindowT<const T> window( SpanT<const T>( a.data(), split ), SpanT<const T>( a.data() + split, 40 - split ) );
+		CHECK( reduce::maximum( window ) == Scalar::maximum( a.data(), 40 ) );
+		CHECK( reduce::minimum( window ) == Scalar::minimum( a.data(), 40 ) );
+		CHECK( near( reduce::sum( window ), Scalar::sum( a.data(), 40 ), (T)1000, 40 ) );
+	}
+	CHECK( reduce::sum( WindowT<const T>() ) == T() && reduce::maximum( WindowT<const T>() ) == T() );
+	std::printf( "%s: %s\n", sizeof( T ) == 8 ? "double" : std::is_integral<T>::value ? "int32_t" : "float", getPath<T>() );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+#if defined( SAMPLING_AVX2 ) && defined( __GNUC__ )
+	if ( !__builtin_cpu_supports( "avx2" ) ) {
+		std::printf( "AVX2 not supported here; skipped\n" );
+		return 0;
+	}
+#elif defined( SAMPLING_AVX ) && defined( __GNUC__ )
+	if ( !__builtin_cpu_supports( "avx" ) ) {
+		std::printf( "AVX not supported here; skipped\n" );
+		return 0;
+	}
+#elif defined( SAMPLING_SSE41 ) && defined( __GNUC__ )
+	if ( !__builtin_cpu_supports( "sse4.1" ) ) {
+		std::printf( "SSE4.1 not supported here; skipped\n" );
+		return 0;
+	}
+#endif
+	testReductions<float>();
+	testReductions<double>();
+	testReductions<int32_t>();
+	return report();
+}
@@ -0,0 +1,153 @@
+/*
+ * Snapshots: ring storage is pinned rather than copied, writes detach
+ * from a live snapshot once, and other storage falls back to a copy.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+// A sample that counts how often it is copied
+struct Counted
+{
+	static int sNumCopies;
+
+	Counted( float v = 0.0f )
+		: value( v )
+	{
+	}
+
+	Counted( const Counted& rhs )
+		: value( rhs.value )
+	{
+		++sNumCopies;
+	}
+
+	Counted( Counted&& rhs ) noexcept
+		: value( rhs.value )
+	{
+	}
+
+	Counted& operator=( const Counted& rhs )
+	{
+		value = rhs.value;
+		++sNumCopies;
+		return *this;
+	}
+
+	Counted& operator=( Counted&& rhs ) noexcept
+	{
+		value = rhs.value;
+		return *this;
+	}
+
+	bool operator==( const Counted& rhs ) const
+	{
+		return value == rhs.value;
+	}
+
+	float value;
+};
+
+int Counted::sNumCopies = 0;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void testSharedSnapshot()
+{
+	typedef RingSamplerT<float, float> Sampler;
+	Sampler sampler( 8 );
+	for ( int i = 0; i < 11; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	const Sampler& owner = sampler;
+	std::vector<float> before( owner.getWindow().begin(), owner.getWindow().end() );
+	{
+		Sampler::Snapshot snapshot = sampler.snapshot();
+		CHECK( snapshot.getGeneration() == sampler.getGeneration() );
+		CHECK( snapshot.getWindow().first().data() == owner.getWindow().first().data() );
+		CHECK( sampler.getStorage().isShared() );
+		CHECK( matches( snapshot, before ) );
+
+		// The first push detaches; the snapshot keeps the old window
+		sampler.pushBack( 100.0f );
+		CHECK( !sampler.getStorage().isShared() );
+		CHECK( snapshot.getWindow().first().data() != owner.getWindow().first().data() );
+		CHECK( matches( snapshot, before ) );
+		CHECK( owner.getWindow().back() == 100.0f && owner.getWindow().front() == 4.0f );
+		for ( int i = 0; i < 20; ++i ) {
+			sampler.pushBack( (float)-i );
+		}
+		CHECK( matches( snapshot, before ) );
+
+		// Snapshots of one generation share one view
+		Sampler::Snapshot a = sampler.snapshot();
+		Sampler::Snapshot b = sampler.snapshot();
+		CHECK( a.getWindow().first().data() == b.getWindow().first().data() );
+		CHECK( a.getWindow().first().data() == owner.getWindow().first().data() );
+	}
+
+	// With every snapshot gone, writes go straight to the same buffer
+	const void* buffer = sampler.getStorage().share().get();
+	CHECK( !sampler.getStorage().isShared() );
+	sampler.pushBack( 1.0f );
+	CHECK( sampler.getStorage().share().get() == buffer );
+
+	// Processes run on a snapshot's window as they would on the sampler's
+	sampler.process( 0, []( const Sampler::Window& window ) { return reduce::sum( window ); } );
+	Sampler::Snapshot snapshot = sampler.snapshot();
+	float expected = sampler.runProcess( 0 );
+	sampler.pushBack( 50.0f );
+	CHECK( sampler.runProcess( 0, snapshot.getWindow() ) == expected );
+}
+
+// A pinned window costs one copy of its live samples at the next write, and none without a snapshot
+static void testDetachCost()
+{
+	typedef SamplerT<Counted, float, RingStorageT<Counted> > Sampler;
+	Sampler sampler( 64 );
+	for ( int i = 0; i < 64; ++i ) {
+		sampler.pushBack( Counted( (float)i ) );
+	}
+	Counted::sNumCopies = 0;
+	for ( int i = 0; i < 100; ++i ) {
+		sampler.pushBack( Counted( (float)i ) );
+		sampler.snapshot();
+	}
+	CHECK( Counted::sNumCopies == 0 );
+
+	// The push evicts the oldest sample first, leaving 63 to copy
+	Sampler::Snapshot snapshot = sampler.snapshot();
+	sampler.pushBack( Counted( 1.0f ) );
+	sampler.pushBack( Counted( 2.0f ) );
+	CHECK( Counted::sNumCopies == 63 );
+	CHECK( snapshot.getWindow().back().value == 99.0f );
+}
+
+// Storage that cannot be shared is copied once per generation
+static void testCopiedSnapshot()
+{
+	typedef SamplerT<float, float> Sampler;
+	Sampler sampler( 4 );
+	for ( int i = 0; i < 6; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	Sampler::Snapshot a = sampler.snapshot();
+	Sampler::Snapshot b = sampler.snapshot();
+	CHECK( a.getWindow().first().data() == b.getWindow().first().data() );
+	CHECK( a.getWindow().first().data() != sampler.getSamples().data() );
+	sampler.pushBack( 9.0f );
+	Sampler::Snapshot c = sampler.snapshot();
+	CHECK( c.getGeneration() == sampler.getGeneration() && c.getWindow().back() == 9.0f );
+	CHECK( a.getWindow().back() == 5.0f && a.size() == 4 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testSharedSnapshot();
+	testDetachCost();
+	testCopiedSnapshot();
+	return report();
+}
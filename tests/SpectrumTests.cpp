@@ -0,0 +1,124 @@
+/*
+ * FftT and SlidingDftT against a DFT computed term by term from the window.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+// Bin k of an n-point DFT of x, each sample scaled by weights
+static std::complex<double> dft( const std::vector<double>& x, size_t k, size_t n, const std::vector<double>& weights )
+{
+	std::complex<double> sum;
+	for ( size_t t = 0; t < x.size(); ++t ) {
+		sum += x[ t ] * weights[ t ] * std::polar( 1.0, -6.283185307179586 * k * t / n );
+	}
+	return sum;
+}
+
+static float signal( int i )
+{
+	return (float)( std::sin( i * 0.49 ) + 0.3 * std::cos( i * 1.7 ) + ( i % 7 ) * 0.1 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every bin, read in place across a wrapped ring window, with each window function
+static void testFft()
+{
+	const size_t N = 64;
+	RingSamplerT<float, float> sampler( N );
+	for ( int i = 0; i < 1000; ++i ) {
+		sampler.pushBack( signal( i ) );
+	}
+	CHECK( !sampler.getWindow().second().empty() );
+	std::vector<double> x( sampler.getWindow().begin(), sampler.getWindow().end() );
+
+	const WindowFunction functions[] = { WINDOW_BLACKMAN, WINDOW_HAMMING, WINDOW_HANN, WINDOW_RECTANGULAR };
+	for ( WindowFunction function : functions ) {
+		std::vector<double> weights( N, 1.0 );
+		for ( size_t i = 0; i < N; ++i ) {
+			double t = 6.283185307179586 * i / N;
+			switch ( function ) {
+			case WINDOW_BLACKMAN:
+				weights[ i ] = 0.42 - 0.5 * std::cos( t ) + 0.08 * std::cos( 2.0 * t );
+				break;
+			case WINDOW_HAMMING:
+				weights[ i ] = 0.54 - 0.46 * std::cos( t );
+				break;
+			case WINDOW_HANN:
+				weights[ i ] = 0.5 - 0.5 * std::cos( t );
+				break;
+			case WINDOW_RECTANGULAR:
+				break;
+			}
+		}
+		FftT<double> fft( N, function );
+		const std::vector<std::complex<double> >& bins = fft.transform( sampler.getWindow() );
+		CHECK( bins.size() == N / 2 + 1 );
+		for ( size_t k = 0; k < bins.size(); ++k ) {
+			CHECK( std::abs( bins[ k ] - dft( x, k, N, weights ) ) < 1e-9 );
+		}
+		const std::vector<double>& magnitudes = fft.magnitudes( sampler.getWindow() );
+		for ( size_t k = 0; k < bins.size(); ++k ) {
+			CHECK( std::fabs( magnitudes[ k ] - std::abs( dft( x, k, N, weights ) ) ) < 1e-9 );
+		}
+	}
+
+	// A short window is zero-padded at the oldest end
+	FftT<double> fft( N, WINDOW_RECTANGULAR );
+	std::vector<double> ones( 10, 1.0 );
+	WindowT<const double> window( SpanT<const double>( ones.data(), ones.size() ) );
+	std::vector<double> padded( N, 0.0 );
+	std::fill( padded.end() - 10, padded.end(), 1.0 );
+	const std::vector<std::complex<double> >& bins = fft.transform( window );
+	for ( size_t k = 0; k < bins.size(); ++k ) {
+		CHECK( std::abs( bins[ k ] - dft( padded, k, N, std::vector<double>( N, 1.0 ) ) ) < 1e-9 );
+	}
+
+	// Sizes round up to a power of two; a plan runs as a process
+	CHECK( FftT<float>( 3 ).getSize() == 4 && FftT<float>( 64 ).getSize() == 64 );
+	FftT<float> hann( N );
+	SamplerT<float, std::vector<float> > spectra( N );
+	spectra.process( 0, std::ref( hann ) );
+	spectra.pushBack( 1.0f );
+	CHECK( spectra.runProcess( 0 ).size() == N / 2 + 1 );
+}
+
+// Tracked bins stay equal to a DFT of the window as samples slide through it
+static void testSlidingDft()
+{
+	const size_t N = 64;
+	const std::vector<double> ones( N, 1.0 );
+	const std::vector<size_t> tracked = { 0, 3, 5, 31, 32 };
+	RingSamplerT<float, float> sampler( N );
+	sampler.accumulate( 0, SlidingDftT<float, float>( N, tracked ) );
+	sampler.accumulate( 1, SlidingDftT<float, float>( N, 5 ) );
+	for ( int i = 0; i < 1000; ++i ) {
+		sampler.pushBack( signal( i ) );
+		if ( i % 97 != 0 && i != 999 ) {
+			continue;
+		}
+		std::vector<double> x( sampler.getWindow().begin(), sampler.getWindow().end() );
+		const SlidingDftT<float, float>* dfts = static_cast<const SlidingDftT<float, float>*>( sampler.getAccumulator( 0 ) );
+		CHECK( dfts->getNumBins() == tracked.size() );
+		double power = 0.0;
+		for ( size_t b = 0; b < tracked.size(); ++b ) {
+			std::complex<double> expected = dft( x, tracked[ b ], N, ones );
+			CHECK( dfts->getBinIndex( b ) == tracked[ b ] );
+			CHECK( std::abs( dfts->getBin( b ) - expected ) < 1e-6 );
+			power += std::norm( dfts->getBin( b ) );
+		}
+		CHECK( std::fabs( sampler.runProcess( 0 ) - std::sqrt( power ) ) < 1e-3 );
+		CHECK( std::fabs( sampler.runProcess( 1 ) - std::abs( dft( x, 5, N, ones ) ) ) < 1e-3 );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testFft();
+	testSlidingDft();
+	return report();
+}
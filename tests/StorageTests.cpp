@@ -0,0 +1,195 @@
+/*
+ * Storage policies: window contents through pushes, appends, resizes and
+ * edits, ring wraparound, and the cost of growing a window and of pushing.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+/*
+ * Pushes, block appends, resizes and edits against a deque model. The
+ * sampler pads the front of its window with zeros after every change but
+ * an erase, and evicts from the front. A ring's window must wrap on the way.
+ */
+template<typename Sampler>
+static void testStorage( size_t numSamples, bool resize, bool ring )
+{
+	Sampler sampler( numSamples );
+	std::deque<float> model;
+	bool wrapped = false;
+	std::mt19937 rng( 7 );
+	float next = 1.0f;
+	for ( int i = 0; i < 2000; ++i ) {
+		int op = (int)( rng() % 16 );
+		bool fit = true;
+		if ( op < 10 ) {
+			sampler.pushBack( next );
+			model.push_back( next );
+			next += 1.0f;
+		} else if ( op < 13 ) {
+			std::vector<float> block( rng() % ( 2 * numSamples + 1 ) );
+			for ( float& v : block ) {
+				v = next;
+				next += 1.0f;
+			}
+			sampler.append( block.data(), block.size() );
+			model.insert( model.end(), block.begin(), block.end() );
+			fit = !block.empty();
+		} else if ( op < 14 && resize ) {
+			sampler.setNumSamples( 1 + rng() % ( 2 * numSamples ) );
+		} else if ( op < 15 || model.empty() ) {
+			size_t index = rng() % ( model.size() + 1 );
+			sampler.insertSample( index, -next );
+			model.insert( model.begin() + index, -next );
+		} else {
+			size_t index = rng() % model.size();
+			sampler.eraseSample( index );
+			model.erase( model.begin() + index );
+			fit = false;
+		}
+		while ( model.size() > sampler.getNumSamples() ) {
+			model.pop_front();
+		}
+		while ( fit && model.size() < sampler.getNumSamples() ) {
+			model.push_front( 0.0f );
+		}
+		wrapped = wrapped || !sampler.getWindow().second().empty();
+		CHECK( matches( sampler.getWindow(), model ) );
+	}
+	CHECK( wrapped == ring );
+}
+
+static void testStorageWraparound()
+{
+	testStorage<SamplerT<float, float> >( 16, true, false );
+	testStorage<RingSamplerT<float, float> >( 16, true, true );
+	testStorage<FixedSamplerT<float, float, 16> >( 16, false, true );
+
+	// A ring splits its window once the head passes the end of the buffer
+	RingSamplerT<float, float> ring( 3 );
+	for ( int i = 0; i < 5; ++i ) {
+		ring.pushBack( (float)i );
+	}
+	RingSamplerT<float, float>::Window window = ring.getWindow();
+	CHECK( !window.second().empty() );
+	CHECK( window.first().size() + window.second().size() == 3 );
+	CHECK( window[ 0 ] == 2.0f && window[ 2 ] == 4.0f );
+}
+
+// A sample that counts every copy and move of itself
+struct Tracked
+{
+	static int sNumTransfers;
+
+	Tracked( float v = 0.0f )
+		: value( v )
+	{
+	}
+
+	Tracked( const Tracked& rhs )
+		: value( rhs.value )
+	{
+		++sNumTransfers;
+	}
+
+	Tracked( Tracked&& rhs ) noexcept
+		: value( rhs.value )
+	{
+		++sNumTransfers;
+	}
+
+	Tracked& operator=( const Tracked& rhs )
+	{
+		value = rhs.value;
+		++sNumTransfers;
+		return *this;
+	}
+
+	Tracked& operator=( Tracked&& rhs ) noexcept
+	{
+		value = rhs.value;
+		++sNumTransfers;
+		return *this;
+	}
+
+	float value;
+};
+
+int Tracked::sNumTransfers = 0;
+
+/*
+ * Growing a full window one slot at a time, 100 times, moves each sample a
+ * bounded number of times rather than once per step. Every step also pads
+ * one slot, which must not shift the window either.
+ */
+template<typename Storage>
+static void testGrowth()
+{
+	SamplerT<Tracked, float, Storage> sampler( 1000 );
+	for ( int i = 0; i < 1000; ++i ) {
+		sampler.pushBack( Tracked( (float)i ) );
+	}
+	Tracked::sNumTransfers = 0;
+	for ( size_t i = 1; i <= 100; ++i ) {
+		sampler.setNumSamples( 1000 + i );
+	}
+	CHECK( Tracked::sNumTransfers < 4000 );
+	CHECK( sampler.getWindow().size() == 1100 );
+	CHECK( sampler.getNumValidSamples() == 1000 && sampler.getWindow()[ 101 ].value == 1.0f );
+	CHECK( sampler.getWindow().back().value == 999.0f );
+
+	// Evicting shifts nothing per push; at most the odd reallocation moves the window
+	Tracked::sNumTransfers = 0;
+	for ( int i = 0; i < 100; ++i ) {
+		sampler.pushBack( Tracked( (float)i ) );
+	}
+	CHECK( Tracked::sNumTransfers < 4000 );
+	CHECK( sampler.getSamples().size() == 1100 );
+	CHECK( sampler.getSamples()[ 999 ].value == 999.0f && sampler.getSamples().back().value == 99.0f );
+}
+
+/*
+ * Pushing an lvalue copies it once, straight into its slot, so it costs
+ * what pushing a temporary does. Pushing the window's own oldest sample,
+ * which is about to be evicted, still pushes its value.
+ */
+template<typename Storage>
+static void testPushCopies()
+{
+	typedef SamplerT<Tracked, float, Storage> Sampler;
+	Sampler copied( 16 ), moved( 16 );
+	for ( int i = 0; i < 40; ++i ) {
+		copied.pushBack( Tracked( (float)i ) );
+		moved.pushBack( Tracked( (float)i ) );
+	}
+	Tracked v( 7.0f );
+	Tracked::sNumTransfers = 0;
+	for ( int i = 0; i < 10; ++i ) {
+		copied.pushBack( v );
+	}
+	int numCopies = Tracked::sNumTransfers;
+	Tracked::sNumTransfers = 0;
+	for ( int i = 0; i < 10; ++i ) {
+		moved.pushBack( Tracked( 7.0f ) );
+	}
+	CHECK( numCopies == Tracked::sNumTransfers );
+
+	for ( int i = 0; i < 100; ++i ) {
+		float oldest = copied.getWindow().front().value;
+		copied.pushBack( copied.getWindow().front() );
+		CHECK( copied.getWindow().back().value == oldest );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testStorageWraparound();
+	testGrowth<RingStorageT<Tracked> >();
+	testGrowth<VectorStorageT<Tracked> >();
+	testPushCopies<RingStorageT<Tracked> >();
+	testPushCopies<VectorStorageT<Tracked> >();
+	return report();
+}
@@ -0,0 +1,46 @@
+/*
+ * Shared scaffolding for the Sampling.h tests. Each tests/<Area>Tests.cpp file
+ * builds into its own executable, registered with ctest under the same
+ * name, and exits non-zero if any CHECK() failed.
+ */
+
+#pragma once
+
+#include "Sampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static int sNumChecks	= 0;
+static int sNumFailures	= 0;
+
+// Not assert(): the tests must also run in release builds
+#define CHECK( expr )																		\
+	do {																					\
+		++sNumChecks;																		\
+		if ( !( expr ) ) {																	\
+			++sNumFailures;																	\
+			std::fprintf( stderr, "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #expr );	\
+		}																					\
+	} while ( 0 )
+
+// Prints the tally; main() returns this
+static inline int report()
+{
+	std::printf( "%d checks, %d failed\n", sNumChecks, sNumFailures );
+	return sNumFailures == 0 ? 0 : 1;
+}
+
+// True if the window holds exactly the values in model, oldest first
+template<typename Window, typename Model>
+static inline bool matches( const Window& window, const Model& model )
+{
+	return window.size() == model.size() && std::equal( window.begin(), window.end(), model.begin() );
+}
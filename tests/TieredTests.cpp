@@ -0,0 +1,112 @@
+/*
+ * Tiered samplers: each tier holds the newest blocks of the input reduced
+ * factor^i to one, however the input arrives.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+// The newest numSamples values of input reduced level times, factor at a time
+static std::vector<float> decimated( std::vector<float> input, size_t factor, size_t level, size_t numSamples, Decimation decimation )
+{
+	for ( size_t l = 0; l < level; ++l ) {
+		std::vector<float> reduced;
+		for ( size_t i = 0; i + factor <= input.size(); i += factor ) {
+			std::vector<float>::const_iterator block = input.begin() + i;
+			switch ( decimation ) {
+			case DECIMATE_MAX:
+				reduced.push_back( *std::max_element( block, block + factor ) );
+				break;
+			case DECIMATE_MEAN:
+				reduced.push_back( reduce::sum( &*block, factor ) / (float)factor );
+				break;
+			case DECIMATE_MIN:
+				reduced.push_back( *std::min_element( block, block + factor ) );
+				break;
+			}
+		}
+		input.swap( reduced );
+	}
+	if ( input.size() > numSamples ) {
+		input.erase( input.begin(), input.end() - numSamples );
+	}
+	return input;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Single pushes and block appends, some longer than tier 0, with each decimation
+static void testTiers( Decimation decimation )
+{
+	typedef TieredSamplerT<float, float> Sampler;
+	Sampler sampler( 8, 3, 4, decimation );
+	sampler.process( 0, []( const WindowT<const float>& window ) { return reduce::sum( window ); } );
+	CHECK( sampler.getNumTiers() == 4 && sampler.getFactor() == 3 && sampler.getNumSamples() == 8 );
+	for ( size_t t = 0; t < sampler.getNumTiers(); ++t ) {
+		sampler.getTier( t ).setPadded( false );
+	}
+
+	std::mt19937 rng( 5 );
+	std::vector<float> input;
+	for ( int i = 0; i < 300; ++i ) {
+		if ( i % 4 == 0 ) {
+			std::vector<float> block( rng() % 20 );
+			for ( float& v : block ) {
+				v = (float)( rng() % 64 );
+			}
+			sampler.append( block.data(), block.size() );
+			input.insert( input.end(), block.begin(), block.end() );
+		} else {
+			float v = (float)( rng() % 64 );
+			sampler.pushBack( v );
+			input.push_back( v );
+		}
+		for ( size_t t = 0; t < sampler.getNumTiers(); ++t ) {
+			std::vector<float> expected = decimated( input, 3, t, 8, decimation );
+			CHECK( matches( sampler.getTier( t ).getWindow(), expected ) );
+			CHECK( std::fabs( sampler.getTier( t ).runProcess( 0 ) - reduce::sum( expected.data(), expected.size() ) ) < 1e-3f );
+		}
+	}
+
+	sampler.clearSamples();
+	sampler.pushBack( 1.0f );
+	sampler.pushBack( 2.0f );
+	CHECK( sampler.getTier( 0 ).getNumValidSamples() == 2 && sampler.getTier( 1 ).getNumValidSamples() == 0 );
+	sampler.pushBack( 3.0f );
+	CHECK( sampler.getTier( 1 ).getNumValidSamples() == 1 );
+}
+
+// Custom reducers, tier lookup by span, and the clamped factor and tier count
+static void testTierSetup()
+{
+	TieredSamplerT<float, float> sampler( 4, 3, 3 );
+	sampler.setReducer( []( const float* block, size_t count ) { return block[ count - 1 ]; } );
+	sampler.getTier( 1 ).setPadded( false );
+	sampler.getTier( 2 ).setPadded( false );
+	for ( int i = 0; i < 9; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	CHECK( matches( sampler.getTier( 1 ).getWindow(), std::vector<float>{ 2.0f, 5.0f, 8.0f } ) );
+	CHECK( matches( sampler.getTier( 2 ).getWindow(), std::vector<float>{ 8.0f } ) );
+
+	CHECK( sampler.findTier( 1 ) == 0 && sampler.findTier( 4 ) == 0 );
+	CHECK( sampler.findTier( 5 ) == 1 && sampler.findTier( 12 ) == 1 );
+	CHECK( sampler.findTier( 13 ) == 2 && sampler.findTier( 100000 ) == 2 );
+
+	TieredSamplerT<int, int> clamped( 2, 0, 0, DECIMATE_MIN );
+	CHECK( clamped.getFactor() == 2 && clamped.getNumTiers() == 1 );
+	clamped.pushBack( 3 );
+	CHECK( clamped.findTier( 1000 ) == 0 && clamped.getTier( 0 ).getWindow().back() == 3 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testTiers( DECIMATE_MAX );
+	testTiers( DECIMATE_MEAN );
+	testTiers( DECIMATE_MIN );
+	testTierSetup();
+	return report();
+}
@@ -0,0 +1,95 @@
+/*
+ * Timed samplers: the window holds exactly the samples younger than the
+ * duration, capped by count, and accumulators follow the evictions.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+enum { ID_MAX, ID_SIZE, ID_SUM };
+
+typedef TimedSamplerT<float, float>		Sampler;
+typedef std::chrono::milliseconds		Milliseconds;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Irregular timestamps, duration changes and explicit expiry, against a list of stamped samples
+static void testExpiry()
+{
+	Sampler sampler( Milliseconds( 50 ), 16 );
+	sampler.accumulate( ID_SUM, RunningSumT<float, float>() ).accumulate( ID_MAX, SlidingMaxT<float, float>() );
+	sampler.process( ID_SIZE, []( const WindowT<const float>& window ) { return (float)window.size(); } );
+	CHECK( sampler.getDuration() == Milliseconds( 50 ) && sampler.getSize() == 0 );
+
+	std::deque<std::pair<Sampler::TimePoint, float> > model;
+	Sampler::Duration duration	= Milliseconds( 50 );
+	Sampler::TimePoint now		= Sampler::Clock::now();
+	std::mt19937 rng( 23 );
+	for ( int i = 0; i < 2000; ++i ) {
+		// Bursts that hit the count cap, and gaps that empty the window
+		now += Milliseconds( i % 200 < 100 ? rng() % 3 : rng() % 40 );
+		if ( i % 500 == 250 ) {
+			now += Milliseconds( 100 );
+		}
+		if ( i % 300 == 299 ) {
+			duration = Milliseconds( 10 + rng() % 80 );
+			sampler.setDuration( duration );
+		}
+		if ( i % 7 == 0 ) {
+			sampler.expire( now );
+		} else {
+			float v = (float)( rng() % 100 );
+			sampler.pushBack( v, now );
+			model.push_back( std::make_pair( now, v ) );
+			if ( model.size() > 16 ) {
+				model.pop_front();
+			}
+		}
+		while ( !model.empty() && now - model.front().first > duration ) {
+			model.pop_front();
+		}
+
+		CHECK( sampler.getSize() == model.size() );
+		CHECK( sampler.getWindow().size() == model.size() );
+		float sum = 0.0f;
+		float max = model.empty() ? 0.0f : model.front().second;
+		for ( size_t s = 0; s < model.size() && s < sampler.getSize(); ++s ) {
+			CHECK( sampler.getTime( s ) == model[ s ].first );
+			CHECK( sampler.getWindow()[ s ] == model[ s ].second );
+			sum += model[ s ].second;
+			max = std::max( max, model[ s ].second );
+		}
+		CHECK( sampler.runProcess( ID_SUM ) == sum );
+		CHECK( sampler.runProcess( ID_SIZE ) == (float)model.size() );
+		if ( !model.empty() ) {
+			CHECK( sampler.runProcess( ID_MAX ) == max );
+		}
+	}
+
+	sampler.clearSamples();
+	CHECK( sampler.getSize() == 0 && sampler.runProcess( ID_SUM ) == 0.0f );
+	sampler.pushBack( 3.0f );
+	CHECK( sampler.getSize() == 1 && sampler.runProcess( ID_SUM ) == 3.0f );
+}
+
+// Popping a padded window keeps its size and pops the accumulators only for real samples
+static void testPaddedPop()
+{
+	SamplerT<float, float> sampler( 4 );
+	sampler.accumulate( ID_SUM, RunningSumT<float, float>() );
+	sampler.pushBack( 1.0f );
+	sampler.pushBack( 2.0f );
+	sampler.popFront( 3 );
+	CHECK( sampler.getWindow().size() == 4 && sampler.getWindow().back() == 2.0f );
+	CHECK( sampler.runProcess( ID_SUM ) == 2.0f );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testExpiry();
+	testPaddedPop();
+	return report();
+}
@@ -0,0 +1,184 @@
+/*
+ * Triggers: each condition fires exactly when the values a process takes
+ * across pushes and blocks meet it, and never for a process that is gone.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+typedef SamplerT<float, float, RingStorageT<float> >	Sampler;
+typedef TriggerEventT<float>							Event;
+
+enum { ID_DOUBLE, ID_MEAN, ID_MISSING, ID_NEWEST, ID_SUM };
+
+// The events condition should raise as a process takes values, one run apart
+static std::vector<Event> expectedEvents( size_t id, size_t index, TriggerCondition condition, float threshold, const std::vector<float>& values )
+{
+	std::vector<Event> events;
+	for ( size_t i = 1; i < values.size(); ++i ) {
+		float previous	= values[ i - 1 ];
+		float value		= values[ i ];
+		bool fires		= false;
+		switch ( condition ) {
+		case TRIGGER_CROSSING:
+			fires = ( previous < threshold ) != ( value < threshold );
+			break;
+		case TRIGGER_FALLING:
+			fires = previous >= threshold && value < threshold;
+			break;
+		case TRIGGER_RATE:
+			fires = std::fabs( value - previous ) >= threshold;
+			break;
+		case TRIGGER_RISING:
+			fires = previous < threshold && value >= threshold;
+			break;
+		}
+		if ( fires ) {
+			Event event = { id, index, previous, value };
+			events.push_back( event );
+		}
+	}
+	return events;
+}
+
+static bool sameEvents( const std::vector<Event>& a, const std::vector<Event>& b )
+{
+	return a.size() == b.size() && std::equal( a.begin(), a.end(), b.begin(), []( const Event& x, const Event& y )
+	{
+		return x.trigger == y.trigger && x.index == y.index && x.previous == y.previous && x.value == y.value;
+	} );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every condition on one process, through single pushes and blocks, with and without an interval
+static void testConditions( size_t interval )
+{
+	const TriggerCondition conditions[] = { TRIGGER_CROSSING, TRIGGER_FALLING, TRIGGER_RATE, TRIGGER_RISING };
+	const float thresholds[] = { 50.0f, 50.0f, 30.0f, 50.0f };
+	Sampler sampler( 8 );
+	sampler.setPadded( false );
+	sampler.setTriggerInterval( interval );
+	CHECK( sampler.getTriggerInterval() == interval );
+	sampler.process( ID_NEWEST, []( const Sampler::Window& window ) { return window.back(); } );
+	std::vector<Event> events[ 4 ];
+	size_t ids[ 4 ];
+	for ( size_t c = 0; c < 4; ++c ) {
+		std::vector<Event>& out = events[ c ];
+		ids[ c ] = sampler.trigger( ID_NEWEST, conditions[ c ], thresholds[ c ], [ &out ]( const Event& event ) { out.push_back( event ); } );
+	}
+
+	// The values the triggers see: the newest sample whenever interval samples have arrived
+	std::vector<float> values;
+	size_t pending = 0;
+	std::mt19937 rng( 30 );
+	for ( int i = 0; i < 500; ++i ) {
+		if ( i % 5 == 0 ) {
+			std::vector<float> block( 1 + rng() % 12 );
+			for ( float& v : block ) {
+				v = (float)( rng() % 100 );
+			}
+			sampler.append( block.data(), block.size() );
+			pending += block.size();
+			if ( pending >= interval ) {
+				values.push_back( block.back() );
+				pending = 0;
+			}
+		} else {
+			float v = (float)( rng() % 100 );
+			sampler.pushBack( v );
+			if ( ++pending >= interval ) {
+				values.push_back( v );
+				pending = 0;
+			}
+		}
+	}
+	for ( size_t c = 0; c < 4; ++c ) {
+		std::vector<Event> expected = expectedEvents( ids[ c ], ID_NEWEST, conditions[ c ], thresholds[ c ], values );
+		CHECK( !expected.empty() );
+		CHECK( sameEvents( events[ c ], expected ) );
+	}
+
+	// Erased triggers stop firing, the others go on
+	size_t numRising = events[ 3 ].size();
+	size_t numRate = events[ 2 ].size();
+	sampler.eraseTrigger( ids[ 3 ] );
+	for ( int i = 0; i < (int)interval * 20; ++i ) {
+		sampler.pushBack( i % 2 == 0 ? 0.0f : 99.0f );
+	}
+	CHECK( events[ 3 ].size() == numRising );
+	CHECK( events[ 2 ].size() > numRate );
+}
+
+// Copies keep triggers; erased, missing and undefined processes are skipped without throwing
+static void testTriggerState()
+{
+	Sampler sampler( 2 );
+	sampler.setPadded( false );
+	sampler.process( ID_NEWEST, []( const Sampler::Window& window ) { return window.back(); } );
+	int numEvents = 0;
+	sampler.trigger( ID_NEWEST, TRIGGER_RATE, 0.0f, [ &numEvents ]( const Event& ) { ++numEvents; } );
+	sampler.trigger( ID_MISSING, TRIGGER_RATE, 0.0f, [ &numEvents ]( const Event& ) { ++numEvents; } );
+	sampler.pushBack( 1.0f );
+	sampler.pushBack( 2.0f );
+	CHECK( numEvents == 1 );
+
+	Sampler copy( sampler );
+	copy.pushBack( 3.0f );
+	CHECK( numEvents == 2 );
+	copy.eraseProcess( ID_NEWEST );
+	copy.process( ID_NEWEST, []( const Sampler::Window& window ) { return window.back(); } );
+	copy.pushBack( 4.0f );
+	copy.pushBack( 5.0f );
+	CHECK( numEvents == 2 );
+
+	sampler.process( ID_NEWEST, nullptr );
+	float block[] = { 7.0f, 8.0f };
+	sampler.pushBack( 6.0f );
+	sampler.append( block, 2 );
+	CHECK( numEvents == 2 );
+	// Once defined again, the value from before the gap is the previous one
+	sampler.process( ID_NEWEST, []( const Sampler::Window& window ) { return window.back(); } );
+	sampler.pushBack( 9.0f );
+	sampler.pushBack( 10.0f );
+	CHECK( numEvents == 4 );
+
+	sampler.clearTriggers();
+	sampler.pushBack( 11.0f );
+	CHECK( numEvents == 4 );
+}
+
+// Triggers on graph nodes and accumulators share the cached evaluation of a push
+static void testCachedTriggers()
+{
+	Sampler sampler( 3 );
+	sampler.setCaching( true );
+	int numSums = 0;
+	sampler.process( ID_SUM, [ &numSums ]( const Sampler::Window& window ) { ++numSums; return reduce::sum( window ); } );
+	sampler.process( ID_DOUBLE, { ID_SUM }, []( const Sampler::Window&, const float* inputs ) { return inputs[ 0 ] * 2.0f; } );
+	sampler.accumulate( ID_MEAN, RunningMeanT<float>() );
+	std::vector<Event> events;
+	sampler.trigger( ID_DOUBLE, TRIGGER_RISING, 10.0f, [ &events ]( const Event& event ) { events.push_back( event ); } );
+	sampler.trigger( ID_SUM, TRIGGER_RISING, 100.0f, [ &events ]( const Event& event ) { events.push_back( event ); } );
+	sampler.trigger( ID_MEAN, TRIGGER_RISING, 3.0f, [ &events ]( const Event& event ) { events.push_back( event ); } );
+	for ( int i = 0; i < 5; ++i ) {
+		sampler.pushBack( 3.0f );
+	}
+	// Sums of the padded window are 3, 6, 9, 9, 9; means 1, 2, 3, 3, 3
+	CHECK( events.size() == 2 && events[ 0 ].index == ID_DOUBLE && events[ 0 ].value == 12.0f );
+	CHECK( events[ 1 ].index == ID_MEAN && events[ 1 ].previous == 2.0f && events[ 1 ].value == 3.0f );
+	CHECK( numSums == 5 );
+	CHECK( sampler.runProcess( ID_SUM ) == 9.0f && numSums == 5 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testConditions( 1 );
+	testConditions( 4 );
+	testTriggerState();
+	testCachedTriggers();
+	return report();
+}
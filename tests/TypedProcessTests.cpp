@@ -0,0 +1,168 @@
+/*
+ * Typed processes: results of their own types from one sampler's window,
+ * next to the Y processes, through copies, moves and erasure.
+ */
+
+#include "Testing.h"
+
+#include <memory>
+
+using namespace sampling;
+
+typedef SamplerT<float, float> Sampler;
+
+struct Histogram
+{
+	std::vector<int> bins;
+};
+
+// A result without a default constructor, counting live instances
+struct Result
+{
+	static int sNumLive;
+
+	explicit Result( int v )
+		: value( v )
+	{
+		++sNumLive;
+	}
+
+	Result( const Result& rhs )
+		: value( rhs.value )
+	{
+		++sNumLive;
+	}
+
+	~Result()
+	{
+		--sNumLive;
+	}
+
+	int value;
+};
+
+int Result::sNumLive = 0;
+
+// A move-only process
+struct Scaled
+{
+	explicit Scaled( double scale )
+		: mScale( new double( scale ) )
+	{
+	}
+
+	double operator()( const Sampler::Window& window ) const
+	{
+		return window.back() * *mScale;
+	}
+
+	std::unique_ptr<double> mScale;
+};
+
+enum { ID_SUM };
+
+const ProcessHandleT<std::vector<float> >	ID_DIFFERENCES( 1 );
+const ProcessHandleT<Histogram>				ID_HISTOGRAM( 0 );
+const ProcessHandleT<std::vector<float> >	ID_MISTYPED( 0 );
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void testTypedProcesses()
+{
+	Sampler sampler( 5 );
+	sampler.process( ID_SUM, []( const Sampler::Window& window ) { return reduce::sum( window ); } );
+	sampler.process( ID_HISTOGRAM, []( const Sampler::Window& window )
+	{
+		Histogram histogram;
+		histogram.bins.assign( 4, 0 );
+		for ( float v : window ) {
+			++histogram.bins[ (int)v % 4 ];
+		}
+		return histogram;
+	} );
+	sampler.process( ID_DIFFERENCES, []( const Sampler::Window& window )
+	{
+		std::vector<float> differences;
+		for ( size_t i = 1; i < window.size(); ++i ) {
+			differences.push_back( window[ i ] - window[ i - 1 ] );
+		}
+		return differences;
+	} );
+	int numCalls = 0;
+	ProcessHandleT<std::string> name = sampler.addProcess( [ &numCalls ]() { ++numCalls; return std::string( "name" ); } );
+	ProcessHandleT<Result> size = sampler.addProcess( []( const Sampler::Window& window ) { return Result( (int)window.size() ); } );
+	CHECK( name.getIndex() == 2 && size.getIndex() == 3 );
+
+	for ( int i = 0; i < 5; ++i ) {
+		sampler.pushBack( (float)( i * i ) );
+	}
+	CHECK( sampler.runProcess( ID_SUM ) == 30.0f );
+	Histogram histogram = sampler.runProcess( ID_HISTOGRAM );
+	CHECK( histogram.bins[ 0 ] == 3 && histogram.bins[ 1 ] == 2 );
+	CHECK( matches( sampler.runProcess( ID_DIFFERENCES ), std::vector<float>{ 1.0f, 3.0f, 5.0f, 7.0f } ) );
+	CHECK( sampler.runProcess( name ) == "name" && numCalls == 1 );
+	CHECK( sampler.runProcess( size ).value == 5 );
+	CHECK( Result::sNumLive == 0 );
+
+	// Other windows, e.g. a snapshot's
+	Sampler::Snapshot snapshot = sampler.snapshot();
+	sampler.pushBack( 100.0f );
+	CHECK( sampler.runProcess( ID_DIFFERENCES, snapshot.getWindow() )[ 3 ] == 7.0f );
+	CHECK( sampler.runProcess( ID_DIFFERENCES )[ 3 ] == 84.0f );
+
+	// Copies and moves keep them; erasure and clearProcesses() drop them
+	Sampler copy( sampler );
+	CHECK( copy.runProcess( ID_HISTOGRAM ).bins.size() == 4 );
+	Sampler moved( std::move( copy ) );
+	CHECK( moved.runProcess( ID_DIFFERENCES ).size() == 4 );
+	moved.eraseProcess( ID_DIFFERENCES );
+	CHECK( moved.addProcess( []() { return 1.0; } ).getIndex() == 1 );
+	moved.clearProcesses();
+	CHECK( moved.addProcess( []() { return 1.0; } ).getIndex() == 0 );
+	CHECK( sampler.runProcess( ID_DIFFERENCES ).size() == 4 );
+
+#if defined( SAMPLING_EXCEPTIONS )
+	// A handle of the wrong type names nothing
+	bool threw = false;
+	try {
+		sampler.runProcess( ID_MISTYPED );
+	} catch ( const ExcProcNotFound& e ) {
+		threw = e.getIndex() == 0;
+	}
+	CHECK( threw );
+
+	threw = false;
+	try {
+		moved.runProcess( ID_HISTOGRAM );
+	} catch ( const ExcProcNotFound& ) {
+		threw = true;
+	}
+	CHECK( threw );
+#endif
+}
+
+// Move-only processes are moved in, and copies of the sampler share them
+static void testMoveOnlyProcesses()
+{
+	Sampler sampler( 4 );
+	for ( int i = 0; i < 4; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	ProcessHandleT<double> scaled( 0 );
+	sampler.process( scaled, Scaled( 3.0 ) );
+	CHECK( sampler.runProcess( scaled ) == 9.0 );
+
+	Sampler copy( sampler );
+	CHECK( copy.runProcess( scaled ) == 9.0 );
+	sampler.process( scaled, Scaled( 2.0 ) );
+	CHECK( sampler.runProcess( scaled ) == 6.0 && copy.runProcess( scaled ) == 9.0 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	testTypedProcesses();
+	testMoveOnlyProcesses();
+	return report();
+}
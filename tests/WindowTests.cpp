@@ -0,0 +1,105 @@
+/*
+ * Sub-window and strided views against the same samples copied out of the
+ * window, over every storage and through edits that shift indices.
+ */
+
+#include "Testing.h"
+
+using namespace sampling;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every tail, range and stride of the window, after each push and edit
+template<typename Sampler>
+static void testViews( Sampler& sampler )
+{
+	for ( int round = 0; round < 40; ++round ) {
+		sampler.pushBack( (float)round );
+		if ( round % 9 == 4 ) {
+			sampler.eraseSample( 2 );
+		} else if ( round % 9 == 7 ) {
+			sampler.insertSample( 1, -1.0f );
+		}
+		WindowT<const float> window = sampler.getWindow();
+		std::vector<float> all( window.begin(), window.end() );
+
+		for ( size_t count = 0; count <= all.size() + 2; ++count ) {
+			size_t size = std::min( count, all.size() );
+			std::vector<float> expected( all.end() - size, all.end() );
+			WindowT<const float> tail = sampler.tail( count );
+			CHECK( matches( tail, expected ) );
+			CHECK( matches( window.tail( count ), expected ) );
+			CHECK( reduce::sum( tail ) == reduce::sum( expected.data(), expected.size() ) );
+		}
+
+		for ( size_t first = 0; first <= all.size() + 1; ++first ) {
+			for ( size_t last = 0; last <= all.size() + 1; ++last ) {
+				size_t end		= std::min( last, all.size() );
+				size_t begin	= std::min( first, end );
+				CHECK( matches( sampler.range( first, last ), std::vector<float>( all.begin() + begin, all.begin() + end ) ) );
+			}
+		}
+
+		for ( size_t step = 0; step <= all.size() + 1; ++step ) {
+			// Counted back from the newest: indices size - 1, size - 1 - step, ...
+			std::vector<float> expected;
+			for ( long i = (long)all.size() - 1; i >= 0; i -= (long)std::max<size_t>( step, 1 ) ) {
+				expected.insert( expected.begin(), all[ i ] );
+			}
+			StridedWindowT<const float> strided = sampler.stride( step );
+			CHECK( strided.getStep() == std::max<size_t>( step, 1 ) );
+			CHECK( matches( strided, expected ) );
+			CHECK( (size_t)( strided.end() - strided.begin() ) == expected.size() );
+			std::vector<float> visited;
+			strided.forEach( [ &visited ]( float v ) { visited.push_back( v ); } );
+			CHECK( visited == expected );
+			for ( size_t i = 0; i < expected.size(); ++i ) {
+				CHECK( strided[ i ] == expected[ i ] && strided.begin()[ (long)i ] == expected[ i ] );
+			}
+			if ( !expected.empty() ) {
+				CHECK( strided.front() == expected.front() && strided.back() == all.back() );
+			}
+		}
+	}
+}
+
+// Processes take the views straight from their window
+static void testViewProcesses()
+{
+	RingSamplerT<float, float> sampler( 7 );
+	sampler.process( 0, []( const WindowT<const float>& window ) { return reduce::sum( window.tail( 3 ) ); } );
+	sampler.process( 1, []( const WindowT<const float>& window )
+	{
+		float sum = 0.0f;
+		window.stride( 2 ).forEach( [ &sum ]( float v ) { sum += v; } );
+		return sum;
+	} );
+	for ( int i = 0; i < 40; ++i ) {
+		sampler.pushBack( (float)i );
+	}
+	CHECK( !sampler.getWindow().isContiguous() );
+	CHECK( sampler.runProcess( 0 ) == 39.0f + 38.0f + 37.0f );
+	CHECK( sampler.runProcess( 1 ) == 39.0f + 37.0f + 35.0f + 33.0f );
+
+	StridedWindowT<float> empty;
+	CHECK( empty.empty() && empty.begin() == empty.end() );
+	StridedWindowT<const float> converted = sampler.stride( 3 );
+	CHECK( converted.size() == 3 && converted.getOffset() == 0 );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	SamplerT<float, float> vector( 7 );
+	testViews( vector );
+	RingSamplerT<float, float> ring( 7 );
+	testViews( ring );
+	RingSamplerT<float, float> unpadded( 6 );
+	unpadded.setPadded( false );
+	testViews( unpadded );
+	FixedSamplerT<float, float, 8> fixed( 8 );
+	testViews( fixed );
+	testViewProcesses();
+	return report();
+}